@@ -45,6 +45,52 @@ struct IOOMEZarrNGFF_EXPORT OMEZarrNGFFAxis
   std::string unit;
 };
 
+/** \class OMEZarrNGFFImageIOEnums
+ *
+ * \brief Enums used by OMEZarrNGFFImageIO
+ *
+ * \ingroup IOOMEZarrNGFF
+ */
+class OMEZarrNGFFImageIOEnums
+{
+public:
+  /** How a lower resolution level is computed from the next higher resolution level. */
+  enum class DownsamplingMethod : uint8_t
+  {
+    Mean,   // average of each block, suited for intensity images
+    Mode,   // most frequent value of each block, suited for label images
+    Stride, // first value of each block, i.e. nearest neighbor
+  };
+
+  /** Quantities measured for each read when read statistics are collected. */
+  enum class ReadStatistic : uint8_t
+  {
+    ChunksRequested, // chunks overlapping the read region
+    ChunksFromCache, // estimate of the requested chunks served from the chunk cache
+    BytesFetched,    // bytes read from the key-value store, before decoding
+    BytesDecoded,    // estimate of the bytes of the chunks decoded, or bytes of the raw chunks copied
+    HTTPRequests,    // HTTP requests issued
+    KVStoreSeconds,  // summed latency of key-value store reads, which may overlap
+    CopySeconds,     // time spent copying raw chunks into the buffer
+    TotalSeconds,    // wall-clock time of the read
+  };
+
+  /** How `Write` treats the store. */
+  enum class WriteMode : uint8_t
+  {
+    Create,      // the region at the image origin (re)creates the store, other streamed regions fill it in
+    RegionWrite, // regions are written into the arrays of an existing store, leaving its metadata alone
+    Update,      // like RegionWrite, but regions may cover chunks partially, for a single writer
+  };
+};
+// Define how to print enumeration
+extern IOOMEZarrNGFF_EXPORT std::ostream &
+                            operator<<(std::ostream & out, const OMEZarrNGFFImageIOEnums::DownsamplingMethod value);
+extern IOOMEZarrNGFF_EXPORT std::ostream &
+                            operator<<(std::ostream & out, const OMEZarrNGFFImageIOEnums::ReadStatistic value);
+extern IOOMEZarrNGFF_EXPORT std::ostream &
+                            operator<<(std::ostream & out, const OMEZarrNGFFImageIOEnums::WriteMode value);
+
 /** \class OMEZarrNGFFImageIO
  *
  * \brief Read and write OMEZarrNGFF images.
@@ -94,7 +140,9 @@ public:
   /** Special in-memory zip interface. An address needs to be provided in
    * the "file name", using pattern address.memory, where address is a
    * decimal representation of BufferInfo's address.
-   * Sample filename: "12341234.memory". */
+   * Sample filename: "12341234.memory".
+   * Writing sets the BufferInfo to a new buffer allocated with `malloc`,
+   * which the caller releases with `free`. */
   using BufferInfo = struct
   {
     char * pointer;
@@ -124,6 +172,118 @@ public:
   void
   Read(void * buffer) override;
 
+  /** Starts reading the given region in the background and returns without blocking,
+   * so that a subsequent `Read` of the region is served from the chunk cache.
+   * Image information must have been read first. Prefetched chunks are only kept
+   * if the cache pool is large enough to hold them, and prefetching is skipped without
+   * a cache pool, see CachePoolSize. At most 16 prefetches are pending at once, beyond
+   * which this waits for the oldest one to complete. */
+  void
+  Prefetch(const ImageIORegion & region);
+
+  /** Blocks until every pending prefetch has completed. */
+  void
+  WaitForPrefetches();
+
+  /** Number of resolution levels ("datasets") of the store whose image information was read. */
+  unsigned
+  GetNumberOfDatasets() const;
+
+  /** Image size, spacing and origin which `ReadImageInformation` sets for a resolution level,
+   * given the current time and channel settings. Reading image information only opens the array
+   * of the level at DatasetIndex. The first query of another level opens its array, which reads
+   * its metadata from the store, but leaves the image information of this ImageIO unchanged. Reading
+   * image information again after changing DatasetIndex reads neither the multiscale metadata nor
+   * the arrays opened before, and keeps the image information of the levels determined before,
+   * unless this process has written the store or invalidated the metadata cache since. Changes by
+   * other writers are thus only noticed after ClearMetadataCache or with a new instance.
+   * Setting another FileName or LabelName discards the levels read. */
+  std::vector<SizeValueType>
+  GetDatasetDimensions(unsigned datasetIndex) const;
+  std::vector<double>
+  GetDatasetSpacing(unsigned datasetIndex) const;
+  std::vector<double>
+  GetDatasetOrigin(unsigned datasetIndex) const;
+
+  /** A region to read into a buffer with `ReadRegions`. The region is given in the ITK index
+   * space of its resolution level, with the dimension of the image information. Time, channel
+   * and dataset indices equal to INVALID_INDEX use the values set on this ImageIO. */
+  struct RegionRead
+  {
+    ImageIORegion region{};
+    void *        buffer{ nullptr }; // holds the pixels of the region with the components of this ImageIO
+    int           timeIndex{ INVALID_INDEX };
+    int           channelIndex{ INVALID_INDEX };
+    int           datasetIndex{ INVALID_INDEX };
+  };
+  using RegionReadListType = std::vector<RegionRead>;
+
+  /** Reads a batch of regions, e.g. random crops for training, issuing the reads of their chunks
+   * concurrently. A chunk overlapping several regions is fetched and decoded once, and released once
+   * the last of those regions has been copied. Chunk reads of the following regions are started
+   * ahead while at most 256 chunks are held, so memory does not grow with the size of the batch.
+   * Image information must have been read first. */
+  void
+  ReadRegions(const RegionReadListType & regionReads);
+
+  /** Number of regions following each read region to prefetch, assuming sequential
+   * streaming along the slowest varying axis that is split. Zero (default) disables
+   * read-ahead. */
+  itkGetConstMacro(ReadAheadDepth, unsigned);
+  itkSetMacro(ReadAheadDepth, unsigned);
+
+  /** Whether chunk-aligned reads of arrays whose chunks are stored uncompressed, in C order and
+   * native byte order, copy the stored chunk bytes straight into the output buffer. This applies to
+   * zarr v2 arrays without compressor or filters and to zarr v3 arrays whose only codec is "bytes",
+   * i.e. without sharding. It skips chunk decoding and the chunk cache, so it is not used while reading
+   * ahead. The CopySeconds read statistic is only nonzero for such reads. On by default. */
+  itkGetConstMacro(DirectChunkReading, bool);
+  itkSetMacro(DirectChunkReading, bool);
+  itkBooleanMacro(DirectChunkReading);
+
+  /** Whether direct chunk reads of arrays stored in local files copy the chunks from memory mappings
+   * of the chunk files, rather than reading each file into an intermediate buffer first. The kernel is
+   * advised to read the mapped chunks sequentially and ahead of the copy. When reading ahead, the chunk
+   * files of the following regions are advised into the page cache rather than prefetched into the
+   * chunk cache. Not available on Windows. Off by default. */
+  itkGetConstMacro(MemoryMappedReading, bool);
+  itkSetMacro(MemoryMappedReading, bool);
+  itkBooleanMacro(MemoryMappedReading);
+
+  /** Whether each `Read` measures the statistics listed in ReadStatistic. The byte and
+   * request counts come from process-wide tensorstore metrics, so they include any other
+   * tensorstore activity running concurrently, such as prefetches. Off by default.
+   *
+   * ChunksFromCache and BytesDecoded are estimates unless raw chunks are copied: each key-value
+   * store read is counted as one chunk fetched and decoded, and the remaining requested chunks as
+   * served from the cache. A cached chunk which is revalidated against the store counts as fetched,
+   * so cache hits are only counted with ImmutableStore on. If tensorstore no longer provides a
+   * metric, or the module was built without tensorstore's metrics registry, the statistics derived
+   * from it are 0 and every requested chunk counts as fetched. */
+  itkGetConstMacro(CollectReadStatistics, bool);
+  itkSetMacro(CollectReadStatistics, bool);
+  itkBooleanMacro(CollectReadStatistics);
+
+  /** Whether collected read statistics are also stored in the MetaDataDictionary as doubles,
+   * with keys "OMEZarrNGFF_LastRead_<Statistic>" and "OMEZarrNGFF_Cumulative_<Statistic>". */
+  itkGetConstMacro(ReadStatisticsInMetaDataDictionary, bool);
+  itkSetMacro(ReadStatisticsInMetaDataDictionary, bool);
+  itkBooleanMacro(ReadStatisticsInMetaDataDictionary);
+
+  using ReadStatisticEnum = OMEZarrNGFFImageIOEnums::ReadStatistic;
+
+  /** Value of a statistic for the most recent `Read`. */
+  double
+  GetLastReadStatistic(ReadStatisticEnum statistic) const;
+
+  /** Value of a statistic summed over all reads since construction or the last reset. */
+  double
+  GetCumulativeReadStatistic(ReadStatisticEnum statistic) const;
+
+  /** Sets all last and cumulative read statistics to zero. */
+  void
+  ResetReadStatistics();
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can write the
@@ -131,26 +291,111 @@ public:
   bool
   CanWriteFile(const char *) override;
 
-  /** Set the spacing and dimension information for the set filename. */
+  /** Set the spacing and dimension information for the set filename,
+   * and create the (empty) array which subsequent `Write` calls fill in. */
   void
   WriteImageInformation() override;
 
   /** Writes the data to disk from the memory buffer provided. Make sure
-   * that the IORegions has been set properly. */
+   * that the IORegions has been set properly.
+   *
+   * Supports streamed writing: the region starting at the image origin
+   * (re)creates the store, and each call only writes its own IO region.
+   * Zip stores are held in memory until the region ending at the image bounds
+   * is written, which writes their archive in a single pass.
+   * In RegionWrite mode no region creates the store, see SetWriteMode. */
   void
   Write(const void * buffer) override;
 
+  /** Recomputes the lower resolution levels where they depend on a modified region of the
+   * resolution level at DatasetIndex, e.g. after editing the region with another tool or
+   * writing it in Update mode with a single resolution level. Only the chunks of each coarser
+   * level covering the downsampled region are read and rewritten, so the work scales with the
+   * size of the region rather than with the size of the image.
+   *
+   * The region is given in the ITK index space of the image information, which must have been
+   * read first. Each level is downsampled from the preceding one with DownsamplingMethod, by the
+   * integer factors relating their array shapes. Only supported for local stores. */
+  void
+  UpdateResolutionLevels(const ImageIORegion & modifiedRegion);
+
   /** Method for supporting streaming.  Given a requested region, determine what
    * could be the region that we can read from the file. This is called the
    * streamable region, which will be smaller than the LargestPossibleRegion and
    * greater or equal to the RequestedRegion.
    *
-   * Under current behavior this simply propagates the requested region.
-   * Could be extended in the future to support chunk-based streaming.
+   * By default this simply propagates the requested region. If ChunkAlignedStreaming
+   * is enabled, the spatial axes of the requested region are grown out to the chunk grid
+   * of the store, so that no chunk is split between streamable regions. Requested regions
+   * thinner than a chunk still share their chunks with the neighbouring requested regions,
+   * which then read them from the cache pool, see ChunkAlignedStreaming.
    */
   ImageIORegion
   GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requestedRegion) const override;
 
+  /** Whether streamable read regions should be aligned to the chunk grid of the store.
+   * Off by default. When on and CachePoolSize is 0, reads use a cache pool of 256 MiB, so that
+   * consecutive streamed regions within the same row of chunks fetch and decode each chunk once.
+   * Chunks of a row which does not fit into the cache pool are decoded again. */
+  itkGetConstMacro(ChunkAlignedStreaming, bool);
+  itkSetMacro(ChunkAlignedStreaming, bool);
+  itkBooleanMacro(ChunkAlignedStreaming);
+
+  /** Number of resolution levels to write. Level `l` is downsampled by a factor of 2
+   * along each spatial axis from level `l - 1`, as each streamed region is written.
+   * Levels are written to consecutive dataset paths starting from DatasetIndex.
+   * Each level is computed from the chunks of the preceding level just written, which are read
+   * from a cache pool of 256 MiB when CachePoolSize is 0, rather than from the store.
+   * Default is 1, which only writes the full resolution image. */
+  itkGetConstMacro(NumberOfResolutionLevels, unsigned);
+  itkSetClampMacro(NumberOfResolutionLevels, unsigned, 1, NumericTraits<unsigned>::max());
+
+  /** How lower resolution levels are computed. Default is Mean, which label images replace with Mode. */
+  using DownsamplingMethodEnum = OMEZarrNGFFImageIOEnums::DownsamplingMethod;
+  itkGetEnumMacro(DownsamplingMethod, DownsamplingMethodEnum);
+  itkSetEnumMacro(DownsamplingMethod, DownsamplingMethodEnum);
+
+  /** How `Write` treats the store. Default is Create, where the region at the image origin
+   * (re)creates the store and the arrays of its resolution levels.
+   *
+   * To write one image concurrently from several threads or processes, create the store once
+   * in Create mode, e.g. by calling WriteImageInformation after setting up the image information,
+   * then let each writer write its own region in RegionWrite mode. RegionWrite opens the existing
+   * arrays at DatasetIndex and the following NumberOfResolutionLevels - 1 paths, without deleting
+   * them or rewriting any metadata. Regions of different writers must not overlap, and each region
+   * must cover whole chunks (shards, if sharded) of every resolution level, and whole downsampling
+   * blocks of every level it is propagated from, except for the partial ones at the array end.
+   * Writers then never touch the same chunk. Other regions are rejected with an exception before
+   * anything is written. The downsampling factors between the existing levels are inferred from
+   * their array shapes, e.g. 1 along z for pyramids downsampled in xy only, and levels which are
+   * not integer downsamplings of the preceding level are rejected.
+   *
+   * Update mode opens the existing arrays like RegionWrite, for editing a region of an existing
+   * image. Only the chunks touched by the region are rewritten, merging partially covered chunks
+   * with their stored values, and lower resolution levels are recomputed where they depend on
+   * the region. Regions may have any shape, so concurrent writers must not use Update mode. */
+  using WriteModeEnum = OMEZarrNGFFImageIOEnums::WriteMode;
+  itkGetEnumMacro(WriteMode, WriteModeEnum);
+  itkSetEnumMacro(WriteMode, WriteModeEnum);
+
+  /** Name of the label image to read or write, within the "labels" group of the OME-NGFF image
+   * at FileName, e.g. a segmentation stored next to the raw data. If empty (default), the image
+   * itself is read or written. All other settings apply to the label image as to an image.
+   *
+   * Writing a label image adds its name to the "labels" group, keeping the label images written
+   * before, and marks it with "image-label" metadata pointing at the image. Its resolution levels
+   * are computed with Mode when DownsamplingMethod is Mean, and its chunks default to the
+   * "BLOSC_ZSTD" compressor, which suits the long runs of integer IDs in label images. The image
+   * must exist, and its zarr format is used for the label image. Label images cannot be written
+   * into zip stores. */
+  itkGetStringMacro(LabelName);
+  itkSetStringMacro(LabelName);
+
+  /** Names of the label images listed in the "labels" group of the image at FileName, in their
+   * listed order. Empty if the image has no labels group. */
+  std::vector<std::string>
+  GetLabelNames();
+
   /** Which resolution level is desired? */
   itkGetConstMacro(DatasetIndex, int);
   itkSetMacro(DatasetIndex, int);
@@ -163,6 +408,129 @@ public:
   itkGetConstMacro(ChannelIndex, int);
   itkSetMacro(ChannelIndex, int);
 
+  /** Whether to read the channel "c" axis into pixel components, rather than slicing
+   * a single channel at ChannelIndex. All selected channels are then read at once into
+   * a multi-component buffer, e.g. for an itk::VectorImage. Off by default. */
+  itkGetConstMacro(ChannelsAsComponents, bool);
+  itkSetMacro(ChannelsAsComponents, bool);
+  itkBooleanMacro(ChannelsAsComponents);
+
+  /** Channels read into pixel components, in component order, when ChannelsAsComponents
+   * is on. If empty (default), every channel is read. */
+  using ChannelIndicesType = std::vector<IndexValueType>;
+  itkGetConstReferenceMacro(ChannelIndices, ChannelIndicesType);
+  itkSetMacro(ChannelIndices, ChannelIndicesType);
+
+  /** Whether to read the time "t" axis into an ITK dimension following the spatial axes,
+   * rather than slicing a single time point at TimeIndex. A window of NumberOfTimePoints
+   * time points starting at TimeIndex is then read at once. The channel "c" axis is not
+   * an ITK dimension in this mode: it is either read into pixel components or sliced
+   * at ChannelIndex. Off by default. */
+  itkGetConstMacro(TimeAsDimension, bool);
+  itkSetMacro(TimeAsDimension, bool);
+  itkBooleanMacro(TimeAsDimension);
+
+  /** Number of time points read when TimeAsDimension is on.
+   * Zero (default) reads through the last time point. */
+  itkGetConstMacro(NumberOfTimePoints, SizeValueType);
+  itkSetMacro(NumberOfTimePoints, SizeValueType);
+
+  /** Chunk shape of written arrays in ITK (Fortran-style) axis order.
+   * Zero entries span the full image extent along that axis. If empty (default),
+   * the chunk shape is chosen to approach TargetChunkSizeInBytes with isotropic
+   * spatial chunks, chunking channel and time axes one element at a time. */
+  using ChunkShapeType = std::vector<SizeValueType>;
+  itkGetConstReferenceMacro(ChunkShape, ChunkShapeType);
+  itkSetMacro(ChunkShape, ChunkShapeType);
+
+  /** Zarr format version of written stores, 2 or 3. Zero (default) writes version 3
+   * with OME-NGFF 0.5 metadata for ".zr3" file names, and version 2 otherwise.
+   * The format of read stores is detected, as is the format of the existing store written
+   * in RegionWrite or Update mode, where a different non-zero format is rejected. */
+  itkGetConstMacro(ZarrFormat, unsigned);
+  itkSetMacro(ZarrFormat, unsigned);
+
+  /** Shard shape of written zarr v3 arrays in ITK (Fortran-style) axis order.
+   * Each shard packs the chunks it holds into a single object using the "sharding_indexed"
+   * codec, while individual chunks remain readable. Zero entries span the full image extent,
+   * and shards are rounded up to hold whole chunks. If empty (default), arrays are not
+   * sharded. Ignored for zarr v2. */
+  itkGetConstReferenceMacro(ShardShape, ChunkShapeType);
+  itkSetMacro(ShardShape, ChunkShapeType);
+
+  /** Target uncompressed size of automatically shaped chunks. The default of 4 MiB
+   * typically compresses to chunks of 1-2 MiB. */
+  itkGetConstMacro(TargetChunkSizeInBytes, SizeValueType);
+  itkSetMacro(TargetChunkSizeInBytes, SizeValueType);
+
+  /** Size limit in bytes of the tensorstore cache pool, which keeps decoded chunks
+   * for reuse by subsequent reads. Zero disables caching, unless ChunkAlignedStreaming is on or
+   * several resolution levels are written. Defaults to GlobalDefaultCachePoolSize. */
+  itkGetConstMacro(CachePoolSize, SizeValueType);
+  itkSetMacro(CachePoolSize, SizeValueType);
+
+  /** Maximum number of concurrent data copy and decode operations. Zero (default) uses
+   * MultiThreaderBase::GetGlobalDefaultNumberOfThreads(), which follows the
+   * ITK_GLOBAL_DEFAULT_NUMBER_OF_THREADS environment variable, as of the next read or write. */
+  itkGetConstMacro(DataCopyConcurrency, unsigned);
+  itkSetMacro(DataCopyConcurrency, unsigned);
+
+  /** Maximum number of concurrent local file operations.
+   * Zero (default) uses the tensorstore default. */
+  itkGetConstMacro(FileIOConcurrency, unsigned);
+  itkSetMacro(FileIOConcurrency, unsigned);
+
+  /** Whether to use a process-wide tensorstore context, shared by every instance with
+   * the same resource limits, so that cached chunks are shared between instances.
+   * Otherwise each instance uses a private context. Defaults to GlobalDefaultUseSharedContext. */
+  itkGetConstMacro(UseSharedContext, bool);
+  itkSetMacro(UseSharedContext, bool);
+  itkBooleanMacro(UseSharedContext);
+
+  /** Whether the stores read are assumed not to change while this instance reads them. If on,
+   * arrays are opened without revalidating the metadata and chunks cached by tensorstore
+   * against the store, which saves round trips, e.g. over HTTP, but misses changes made by other
+   * writers. The multiscale metadata of a store is then also not read again by ReadImageInformation
+   * once read. Off by default, where cached metadata is revalidated when opening an array, and cached
+   * chunks when reading them. */
+  itkGetConstMacro(ImmutableStore, bool);
+  itkSetMacro(ImmutableStore, bool);
+  itkBooleanMacro(ImmutableStore);
+
+  /** JSON specification of the tensorstore context of the last read or write, which holds
+   * the resource limits in effect, e.g. "data_copy_concurrency". */
+  std::string
+  GetTensorStoreContextSpec() const;
+
+  /** Defaults for the cache pool size and shared context use of new instances,
+   * including instances created by the object factory. */
+  static void
+  SetGlobalDefaultCachePoolSize(SizeValueType cachePoolSize);
+  static SizeValueType
+  GetGlobalDefaultCachePoolSize();
+  static void
+  SetGlobalDefaultUseSharedContext(bool useSharedContext);
+  static bool
+  GetGlobalDefaultUseSharedContext();
+
+  /** Parsed group metadata and opened arrays can be kept in a process-wide cache keyed by
+   * normalized store path, so that probing a store with CanReadFile, reading its information,
+   * and reading it again with other instances do not repeat metadata round trips.
+   * Entries expire after the given time to live in seconds. Zero (default) disables the cache,
+   * and negative values keep entries until they are invalidated. Entries of a store are
+   * invalidated when it is written by this process, but not when other writers change it.
+   * Opened arrays are only shared between instances using the same shared context, see
+   * UseSharedContext, and the same ImmutableStore setting; other instances open arrays in
+   * their own context. In-memory zip stores are never cached. */
+  static void
+  SetMetadataCacheTimeToLive(double seconds);
+  static double
+  GetMetadataCacheTimeToLive();
+
+  /** Remove all entries from the process-wide metadata cache. */
+  static void
+  ClearMetadataCache();
+
   /** Get the available axes in the OME-Zarr store in ITK (Fortran-style) order.
    *  This is reversed from the default C-style order of
    *  axes as used in the Zarr / NumPy / Tensorstore interface.
@@ -188,14 +556,65 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
-  /** Read a single array and set relevant metadata. */
+  /** Validate compressor names. Supported compressors are "BLOSC" (an alias for "BLOSC_LZ4"),
+   * "BLOSC_LZ4", "BLOSC_ZSTD", "BLOSC_BLOSCLZ", "ZSTD", "GZIP" and "NONE" for uncompressed chunks.
+   * The default empty compressor writes "BLOSC_LZ4", or "BLOSC_ZSTD" for label images. The
+   * compression level (0-9) is passed to the selected codec. Note that compression is not disabled
+   * by `SetUseCompression(false)`, use the "NONE" compressor instead. */
+  void
+  InternalSetCompressor(const std::string & _compressor) override;
+
+  /** (Re)create the tensorstore context if the resource settings changed. */
+  void
+  UpdateTensorStoreContext();
+
+  /** Path of the group holding the multiscale image, i.e. the store or its label image at LabelName. */
+  std::string
+  GetGroupPath() const;
+
+  /** Downsampling method of the resolution levels written, accounting for label images. */
+  DownsamplingMethodEnum
+  GetLevelDownsamplingMethod() const;
+
+  /** Read the multiscale metadata of the store, unless it was read before and the store may not have changed,
+   * keeping the arrays opened before unless the metadata changed. */
   void
-  ReadArrayMetadata(std::string path, std::string driver);
+  ReadMultiscaleMetadata();
+
+  /** Determine the image size, spacing and origin of a resolution level, unless already determined
+   * with the current time and channel settings, opening its array if needed. */
+  void
+  RecordDatasetGeometry(unsigned datasetIndex) const;
+
+  /** Compute the image size, spacing and origin of a resolution level from the multiscale metadata read
+   * and the shape of its array in store order, given the current time and channel settings. */
+  void
+  ComputeDatasetGeometry(unsigned                     datasetIndex,
+                         const std::vector<int64_t> & storeShape,
+                         std::vector<SizeValueType> & dimensions,
+                         std::vector<double> &        spacing,
+                         std::vector<double> &        origin) const;
+
+  /** Set the image information of a resolution level of the multiscale metadata read. */
+  void
+  ReadDatasetMetadata(unsigned datasetIndex);
+
+  /** Set relevant metadata from the opened array of a resolution level. */
+  void
+  ReadArrayMetadata(unsigned datasetIndex);
+
+  /** Open the existing arrays of the resolution levels written in RegionWrite or Update mode, unless already open. */
+  void
+  OpenArraysForRegionWrite();
 
   /** Process requested store region for given configuration */
   ImageIORegion
   ConfigureTensorstoreIORegion(const ImageIORegion & ioRegion) const;
 
+  /** Process requested store region for given configuration, slicing the given time and channel indices */
+  ImageIORegion
+  ConfigureTensorstoreIORegion(const ImageIORegion & ioRegion, int timeIndex, int channelIndex) const;
+
   /** Helper method to get axes in tensorstore C-style order*/
   AxesCollectionType
   GetAxesInStoreOrder() const
@@ -218,6 +637,10 @@ protected:
     }
   }
 
+  /** Removes an ITK axis, keeping the spacing and origin of the remaining axes. */
+  void
+  RemoveDimension(unsigned axis);
+
   ImageIORegion
   GetLargestRegion()
   {
@@ -236,17 +659,33 @@ protected:
   const std::vector<std::string> dimensionUnits = { "millimeter", "millimeter", "millimeter", "index", "second" };
 
 private:
-  int                m_DatasetIndex = 0; // first, highest resolution scale by default
-  int                m_TimeIndex = INVALID_INDEX;
-  int                m_ChannelIndex = INVALID_INDEX;
-  AxesCollectionType m_StoreAxes;
-
-  // An empty zip file consists of 22 bytes of "end of central directory" record. More:
-  // https://github.com/google/tensorstore/blob/45565464b9f9e2567144d780c3bef365ee3c125a/tensorstore/internal/compression/zip_details.h#L64-L76
-  constexpr static unsigned m_EmptyZipSize = 22;
-  char                      m_EmptyZip[m_EmptyZipSize] = "PK\x05\x06"; // the rest is filled with zeroes
-  const BufferInfo          m_EmptyZipBufferInfo{ m_EmptyZip, m_EmptyZipSize };
-  const std::string         m_EmptyZipFileName = MakeMemoryFileName(m_EmptyZipBufferInfo);
+  std::string            m_LabelName{};
+  int                    m_DatasetIndex = 0; // first, highest resolution scale by default
+  int                    m_TimeIndex = INVALID_INDEX;
+  int                    m_ChannelIndex = INVALID_INDEX;
+  bool                   m_ChannelsAsComponents = false;
+  ChannelIndicesType     m_ChannelIndices{};
+  bool                   m_TimeAsDimension = false;
+  SizeValueType          m_NumberOfTimePoints = 0;
+  bool                   m_ChunkAlignedStreaming = false;
+  unsigned               m_ReadAheadDepth = 0;
+  bool                   m_DirectChunkReading = true;
+  bool                   m_MemoryMappedReading = false;
+  bool                   m_CollectReadStatistics = false;
+  bool                   m_ReadStatisticsInMetaDataDictionary = false;
+  ChunkShapeType         m_ChunkShape{};
+  unsigned               m_ZarrFormat = 0;
+  ChunkShapeType         m_ShardShape{};
+  SizeValueType          m_TargetChunkSizeInBytes = 4 * 1024 * 1024;
+  unsigned               m_NumberOfResolutionLevels = 1;
+  DownsamplingMethodEnum m_DownsamplingMethod = DownsamplingMethodEnum::Mean;
+  WriteModeEnum          m_WriteMode = WriteModeEnum::Create;
+  SizeValueType          m_CachePoolSize = 0;
+  unsigned               m_DataCopyConcurrency = 0;
+  unsigned               m_FileIOConcurrency = 0;
+  bool                   m_UseSharedContext = false;
+  bool                   m_ImmutableStore = false;
+  AxesCollectionType     m_StoreAxes;
 
   struct TensorStoreData;
   const std::unique_ptr<TensorStoreData> m_TensorStoreData;
@@ -16,6 +16,7 @@ itk_module(IOOMEZarrNGFF
   TEST_DEPENDS
     ITKTestKernel
     ITKMetaIO
+    ITKImageGrid
   FACTORY_NAMES
     ImageIO::OMEZarrNGFF
   DESCRIPTION
@@ -21,17 +21,52 @@
 #include "itkIntTypes.h"
 #include "itkByteSwapper.h"
 #include "itkMacro.h"
+#include "itkMetaDataObject.h"
+#include "itkMultiThreaderBase.h"
+#include "itk_zlib.h"
 
+#include "tensorstore/chunk_layout.h"
 #include "tensorstore/container_kind.h"
 #include "tensorstore/context.h"
+#include "tensorstore/downsample.h"
+#include "tensorstore/downsample_method.h"
 #include "tensorstore/index_space/dim_expression.h"
 #include "tensorstore/open.h"
 #include "tensorstore/index_space/index_domain.h"
 #include "tensorstore/index_space/index_domain_builder.h"
-#include "tensorstore/index_space/dim_expression.h"
+#include "tensorstore/kvstore/kvstore.h"
+#include "tensorstore/kvstore/operations.h"
+#ifdef ITK_OMEZARRNGFF_HAVE_TENSORSTORE_METRICS
+#  include "tensorstore/internal/metrics/collect.h"
+#  include "tensorstore/internal/metrics/registry.h"
+#endif
+#include "tensorstore/util/executor.h"
+#include "tensorstore/util/future.h"
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <type_traits>
+#include <variant>
+
+#ifndef _WIN32
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
 // Evaluate tensorstore future (statement) and error-check the result.
 #define TS_EVAL_CHECK(statement)                                          \
   {                                                                       \
@@ -172,6 +207,48 @@ MakePath(const int datasetIndex)
   return 's' + std::to_string(datasetIndex);
 }
 
+// Returns the ITK axis index for a spatial OME-Zarr axis name,
+// or -1 if the named axis is not spatial.
+int
+GetSpatialITKAxis(const std::string & axisName)
+{
+  if (axisName == "x")
+  {
+    return 0;
+  }
+  if (axisName == "y")
+  {
+    return 1;
+  }
+  if (axisName == "z")
+  {
+    return 2;
+  }
+  return -1;
+}
+
+// Returns the read chunk shape of the store in tensorstore (C-style) axis order, or the write
+// chunk shape, which is the shard shape of sharded arrays, if `writeChunks` is set.
+// Axes without a chunk constraint are treated as a single chunk spanning the store extent.
+std::vector<tensorstore::Index>
+GetChunkShape(const tensorstore::TensorStore<> & store, const bool writeChunks = false)
+{
+  auto layout = store.chunk_layout();
+  if (!layout.ok())
+  {
+    itkGenericExceptionMacro("tensorstore error: " << layout.status());
+  }
+  const auto chunkShape = writeChunks ? layout.value().write_chunk_shape() : layout.value().read_chunk_shape();
+  const auto                      storeShape = store.domain().shape();
+  std::vector<tensorstore::Index> result(store.rank());
+  for (tensorstore::DimensionIndex dim = 0; dim < store.rank(); ++dim)
+  {
+    const bool isChunked = dim < static_cast<tensorstore::DimensionIndex>(chunkShape.size()) && chunkShape[dim] > 0;
+    result[dim] = isChunked ? chunkShape[dim] : std::max<tensorstore::Index>(storeShape[dim], 1);
+  }
+  return result;
+}
+
 // Returns TensorStore KvStore driver name appropriate for this path.
 // Options are file, zip. TODO: http, gcs (GoogleCouldStorage), etc.
 std::string
@@ -192,11 +269,71 @@ getKVstoreDriver(std::string path)
   return "file";
 }
 
+// Returns the OME-NGFF attributes of a zarr v3 group ("zarr.json").
+// As of OME-NGFF 0.5 these are nested under "ome".
+nlohmann::json
+GetZarr3OMEAttributes(const nlohmann::json & zarrJson)
+{
+  const auto & attributes = zarrJson.at("attributes");
+  return attributes.contains("ome") ? attributes.at("ome") : attributes;
+}
+
+// Returns the value of a tensorstore result, or throws an exception with its error status.
+template <typename T>
+T
+ValueOrThrow(tensorstore::Result<T> result)
+{
+  if (!result.ok())
+  {
+    itkGenericExceptionMacro("tensorstore error: " << result.status());
+  }
+  return std::move(result).value();
+}
+
+// Describes a store axis which is read into pixel components rather than an ITK axis.
+struct ComponentAxis
+{
+  tensorstore::DimensionIndex     storeIndex{ -1 }; // no component axis by default
+  std::vector<tensorstore::Index> selection{};      // positions to read along the axis, or empty to read the IO region
+};
+
+// Whether the indices form a single increasing run, such as {2, 3, 4}.
+bool
+IsContiguousRun(const std::vector<IndexValueType> & indices)
+{
+  for (size_t i = 1; i < indices.size(); ++i)
+  {
+    if (indices[i] != indices[0] + static_cast<IndexValueType>(i))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns a view of the store restricted to an IO region given in store axis order.
+tensorstore::TensorStore<>
+SliceStore(const tensorstore::TensorStore<> & store, const ImageIORegion & storeIORegion)
+{
+  const auto                      dimension = store.rank();
+  std::vector<tensorstore::Index> indices(dimension);
+  std::vector<tensorstore::Index> sizes(dimension);
+  for (size_t dim = 0; dim < dimension; ++dim)
+  {
+    indices[dim] = storeIORegion.GetIndex(dim);
+    sizes[dim] = storeIORegion.GetSize(dim);
+  }
+  return ValueOrThrow(store | tensorstore::AllDims().SizedInterval(indices, sizes));
+}
+
 template <typename TPixel>
 void
-ReadFromStore(const tensorstore::TensorStore<> & store, const ImageIORegion & storeIORegion, TPixel * buffer)
+ReadFromStore(const tensorstore::TensorStore<> & store,
+              const ImageIORegion &              storeIORegion,
+              const ComponentAxis &              componentAxis,
+              TPixel *                           buffer)
 {
-  if (store.domain().num_elements() == storeIORegion.GetNumberOfPixels())
+  if (componentAxis.storeIndex < 0 && store.domain().num_elements() == storeIORegion.GetNumberOfPixels())
   {
     // Read the entire available voxel region.
     // Allow tensorstore to perform any axis permutations or other index operations
@@ -217,20 +354,27 @@ ReadFromStore(const tensorstore::TensorStore<> & store, const ImageIORegion & st
     //
     // In the future this may be extended to permute axes based on
     // OME-Zarr NGFF axis labels.
-    const auto                      dimension = store.rank();
-    std::vector<tensorstore::Index> indices(dimension);
-    std::vector<tensorstore::Index> sizes(dimension);
-    for (size_t dim = 0; dim < dimension; ++dim)
+    //
+    // Input IO region is assumed to already be reversed from ITK requested region
+    // to match assumed C-style Zarr storage
+    tensorstore::TensorStore<> indexedStore = SliceStore(store, storeIORegion);
+
+    if (componentAxis.storeIndex >= 0)
     {
-      // Input IO region is assumed to already be reversed from ITK requested region
-      // to match assumed C-style Zarr storage
-      indices[dim] = storeIORegion.GetIndex(dim);
-      sizes[dim] = storeIORegion.GetSize(dim);
+      // Select positions along the component axis, then move it to the last (fastest moving)
+      // position so that all components are read at once and interleaved per pixel.
+      if (!componentAxis.selection.empty())
+      {
+        const std::vector<tensorstore::Index> selectionShape = { static_cast<tensorstore::Index>(
+          componentAxis.selection.size()) };
+        auto selection = tensorstore::Array(componentAxis.selection.data(), selectionShape, tensorstore::c_order);
+        indexedStore = ValueOrThrow(indexedStore | tensorstore::Dims(componentAxis.storeIndex)
+                                                     .IndexArraySlice(tensorstore::UnownedToShared(selection)));
+      }
+      indexedStore = ValueOrThrow(indexedStore | tensorstore::Dims(componentAxis.storeIndex).MoveToBack());
     }
-    auto indexDomain = tensorstore::IndexDomainBuilder(dimension).origin(indices).shape(sizes).Finalize().value();
 
-    auto arr = tensorstore::Array(buffer, indexDomain.shape(), tensorstore::c_order);
-    auto indexedStore = store | tensorstore::AllDims().SizedInterval(indices, sizes);
+    auto arr = tensorstore::Array(buffer, indexedStore.domain().shape(), tensorstore::c_order);
     tensorstore::Read(indexedStore, tensorstore::UnownedToShared(arr)).value();
   }
 }
@@ -241,11 +385,12 @@ bool
 ReadFromStoreIfTypesMatch(const IOComponentEnum              componentType,
                           const tensorstore::TensorStore<> & store,
                           const ImageIORegion &              storeIORegion,
+                          const ComponentAxis &              componentAxis,
                           void *                             buffer)
 {
   if (tensorstoreToITKComponentType(tensorstore::dtype_v<TPixel>) == componentType)
   {
-    ReadFromStore(store, storeIORegion, static_cast<TPixel *>(buffer));
+    ReadFromStore(store, storeIORegion, componentAxis, static_cast<TPixel *>(buffer));
     return true;
   }
   return false;
@@ -258,570 +403,3489 @@ TryToReadFromStore(TypeList<TPixel...>,
                    const IOComponentEnum              componentType,
                    const tensorstore::TensorStore<> & store,
                    const ImageIORegion &              storeIORegion,
+                   const ComponentAxis &              componentAxis,
                    void *                             buffer)
 {
-  return (ReadFromStoreIfTypesMatch<TPixel>(componentType, store, storeIORegion, buffer) || ...);
+  return (ReadFromStoreIfTypesMatch<TPixel>(componentType, store, storeIORegion, componentAxis, buffer) || ...);
 }
 
-// Writes to the store if the specified pixel type and the ITK component type match.
-template <typename TPixel>
+// Chunk grid of a zarr array whose chunks are stored as raw bytes in the layout of the ITK buffer.
+struct RawChunkLayout
+{
+  std::vector<tensorstore::Index> chunkShape{};
+  std::string                     keyPrefix{};      // precedes the chunk grid indices in chunk keys
+  std::string                     separator{ "." }; // separates chunk grid indices in chunk keys
+};
+
+// Gets the raw chunk layout of zarr v2 array metadata without compressor or filters.
 bool
-WriteToStoreIfTypesMatch(const IOComponentEnum        componentType,
-                         tensorstore::TensorStore<> & store,
-                         tensorstore::Context &       tsContext,
-                         const std::string &          fileName,
-                         const std::string &          path,
-                         const std::vector<int64_t> & shape,
-                         const void * const           buffer)
+GetZarr2RawChunkLayout(const nlohmann::json & metadata, RawChunkLayout & layout)
 {
-  if (tensorstoreToITKComponentType(tensorstore::dtype_v<TPixel>) == componentType)
+  const nlohmann::json dtype = metadata.value("dtype", nlohmann::json());
+  const char           nativeByteOrder = ByteSwapper<int>::SystemIsBigEndian() ? '>' : '<';
+  if (!metadata.value("compressor", nlohmann::json()).is_null() ||
+      !metadata.value("filters", nlohmann::json()).is_null() || metadata.value("order", "C") != "C" ||
+      !dtype.is_string() || dtype.get<std::string>().empty() ||
+      (dtype.get<std::string>()[0] != '|' && dtype.get<std::string>()[0] != nativeByteOrder) ||
+      !metadata.contains("chunks"))
   {
-    std::string dtype;
-    // we prefer to write using our own endianness, so no conversion is necessary
-    if (ByteSwapper<int>::SystemIsBigEndian())
-    {
-      dtype = ">";
-    }
-    else
-    {
-      dtype = "<";
-    }
-
-    if (sizeof(TPixel) == 1)
-    {
-      dtype = "|";
-    }
-    if (std::numeric_limits<TPixel>::is_integer)
-    {
-      if (std::numeric_limits<TPixel>::is_signed)
-      {
-        dtype += 'i';
-      }
-      else
-      {
-        dtype += 'u';
-      }
-    }
-    else
-    {
-      dtype += 'f';
-    }
-    dtype += std::to_string(sizeof(TPixel));
-
-    auto openFuture = tensorstore::Open(
-      {
-        { "driver", "zarr" },
-        { "kvstore", { { "driver", getKVstoreDriver(fileName) }, { "path", fileName + "/" + path } } },
-        { "metadata",
-          {
-            { "compressor", { { "id", "blosc" } } },
-            { "dtype", dtype },
-            { "shape", shape },
-          } },
-      },
-      tsContext,
-      tensorstore::OpenMode::create | tensorstore::OpenMode::delete_existing,
-      tensorstore::ReadWriteMode::read_write);
-    TS_EVAL_CHECK(openFuture);
-
-    auto   writeStore = openFuture.value();
-    auto * p = static_cast<TPixel const *>(buffer);
-    auto   arr = tensorstore::Array(p, shape, tensorstore::c_order);
-    auto   writeFuture = tensorstore::Write(tensorstore::UnownedToShared(arr), writeStore);
-    TS_EVAL_CHECK(writeFuture);
-    return true;
+    return false;
   }
-  return false;
+  layout.chunkShape = metadata.at("chunks").get<std::vector<tensorstore::Index>>();
+  layout.keyPrefix.clear();
+  layout.separator = metadata.value("dimension_separator", ".");
+  return true;
 }
 
-// Tries to write to the specified store, trying any of the specified pixel types.
-template <typename... TPixel>
+// Gets the raw chunk layout of zarr v3 array metadata whose only codec is the "bytes" codec,
+// which excludes compressed, transposed and sharded chunks.
 bool
-TryToWriteToStore(TypeList<TPixel...>,
-                  const IOComponentEnum        componentType,
-                  tensorstore::TensorStore<> & store,
-                  tensorstore::Context &       tsContext,
-                  const std::string &          fileName,
-                  const std::string &          path,
-                  const std::vector<int64_t> & shape,
-                  const void * const           buffer)
-{
-  return (WriteToStoreIfTypesMatch<TPixel>(componentType, store, tsContext, fileName, path, shape, buffer) || ...);
-}
-
-// Update an existing "read" specification for an "http" driver to retrieve remote files.
-// Note that an "http" driver specification may operate on an HTTP or HTTPS connection.
-void
-MakeKVStoreHTTPDriverSpec(nlohmann::json & spec, const std::string & fullPath)
+GetZarr3RawChunkLayout(const nlohmann::json & metadata, const size_t elementSize, RawChunkLayout & layout)
 {
-  // Decompose path into a base URL and reference subpath according to TensorStore HTTP KVStore driver spec
-  // https://google.github.io/tensorstore/kvstore/http/index.html
-  spec["kvstore"] = { { "driver", "http" } };
-
-  // Naively decompose the URL into "base" and "resource" components.
-  // Generally assumes that the spec will only be used once to access a specific resource.
-  // For example, the URL "http://localhost/path/to/resource.json" will be split
-  // into components "http://localhost/path/to" and "resource.json".
-  //
-  // Could be revisited for a better root "base_url" at the top level allowing acces
-  // to multiple subpaths. For instance, decomposing the example above into
-  // "http://localhost/" and "path/to/resource.json" would allow for a given HTTP spec
-  // to be more easily reused with different subpaths.
-  //
-  spec["kvstore"]["base_url"] = fullPath.substr(0, fullPath.find_last_of("/"));
-  spec["kvstore"]["path"] = fullPath.substr(fullPath.find_last_of("/") + 1);
-}
+  const nlohmann::json codecs = metadata.value("codecs", nlohmann::json());
+  if (!codecs.is_array() || codecs.size() != 1 || !codecs[0].is_object() || codecs[0].value("name", "") != "bytes")
+  {
+    return false;
+  }
+  const nlohmann::json codecConfiguration = codecs[0].value("configuration", nlohmann::json::object());
+  const nlohmann::json endian =
+    codecConfiguration.is_object() ? codecConfiguration.value("endian", nlohmann::json()) : nlohmann::json();
+  const char * nativeEndian = ByteSwapper<int>::SystemIsBigEndian() ? "big" : "little";
+  if (endian.is_null() ? elementSize != 1 : endian != nativeEndian)
+  {
+    return false;
+  }
 
-// JSON file path, e.g. "C:/Dev/ITKIOOMEZarrNGFF/v0.4/cyx.ome.zarr/.zgroup"
-void
-writeJson(nlohmann::json json, std::string path, std::string driver, tensorstore::Context& tsContext)
-{
-  auto attrs_store = tensorstore::Open<nlohmann::json, 0>(
-                       { { "driver", "json" }, { "kvstore", { { "driver", driver }, { "path", path } } } },
-                       tsContext,
-                       tensorstore::OpenMode::create | tensorstore::OpenMode::delete_existing,
-                       tensorstore::ReadWriteMode::read_write)
-                       .result()
-                       .value();
-  auto writeFuture = tensorstore::Write(tensorstore::MakeScalarArray(json), attrs_store); // preferably pretty-print
+  const nlohmann::json chunkGrid = metadata.value("chunk_grid", nlohmann::json());
+  if (!chunkGrid.is_object() || chunkGrid.value("name", "") != "regular" || !chunkGrid.contains("configuration") ||
+      !chunkGrid.at("configuration").is_object() || !chunkGrid.at("configuration").contains("chunk_shape"))
+  {
+    return false;
+  }
 
-  auto result = writeFuture.result();
-  if (!result.ok())
+  // Keys of the "default" encoding are e.g. "c/0/2/1", those of the "v2" encoding e.g. "0.2.1"
+  const nlohmann::json keyEncoding = metadata.value("chunk_key_encoding", nlohmann::json::object());
+  if (!keyEncoding.is_object())
   {
-    itkGenericExceptionMacro(<< "There was an error writing metadata to file '" << path
-                             << ". Error details: " << result.status());
+    return false;
+  }
+  const nlohmann::json keyConfiguration = keyEncoding.value("configuration", nlohmann::json::object());
+  const std::string    encodingName = keyEncoding.value("name", "default");
+  if (!keyConfiguration.is_object() || (encodingName != "default" && encodingName != "v2"))
+  {
+    return false;
   }
+  layout.separator = keyConfiguration.value("separator", encodingName == "default" ? "/" : ".");
+  layout.keyPrefix = encodingName == "default" ? "c" + layout.separator : std::string();
+  layout.chunkShape = chunkGrid.at("configuration").at("chunk_shape").get<std::vector<tensorstore::Index>>();
+  return true;
 }
 
-// JSON file path, e.g. "C:/Dev/ITKIOOMEZarrNGFF/v0.4/cyx.ome.zarr/.zattrs"
+// Gets the raw chunk layout of the store, if its chunks are stored uncompressed and unfiltered in
+// C order and native byte order. Reversing the axes of such chunks gives the ITK buffer layout.
 bool
-jsonRead(const std::string path, nlohmann::json & result, std::string driver, tensorstore::Context& tsContext)
+GetRawChunkLayout(const tensorstore::TensorStore<> & store, RawChunkLayout & layout)
 {
-  // Reading JSON via TensorStore allows it to be in the cloud
-  nlohmann::json readSpec = { { "driver", "json" }, { "kvstore", { { "driver", driver }, { "path", path } } } };
-  if (driver == "http")
-  {
-    MakeKVStoreHTTPDriverSpec(readSpec, path);
-  }
-
-  auto attrs_store = tensorstore::Open<nlohmann::json, 0>(readSpec, tsContext).result().value();
-
-  auto attrs_array_result = tensorstore::Read(attrs_store).result();
-
-  nlohmann::json attrs;
-  if (attrs_array_result.ok())
+  auto spec = store.spec();
+  if (!spec.ok())
   {
-    result = attrs_array_result.value()();
-    return true;
+    return false;
   }
-  else if (absl::IsNotFound(attrs_array_result.status()))
+  auto specJson = spec->ToJson();
+  if (!specJson.ok() || !specJson->contains("metadata") || !specJson->at("metadata").is_object())
   {
-    result = nlohmann::json::object_t();
     return false;
   }
-  else // another error
+  for (const auto origin : store.domain().origin())
   {
-    result = nlohmann::json::object_t();
-    return false;
+    if (origin != 0)
+    {
+      return false;
+    }
   }
+
+  const std::string      driver = specJson->value("driver", "");
+  const nlohmann::json & metadata = specJson->at("metadata");
+  const bool             isRaw = driver == "zarr"    ? GetZarr2RawChunkLayout(metadata, layout)
+                                 : driver == "zarr3" ? GetZarr3RawChunkLayout(metadata, store.dtype().size(), layout)
+                                                     : false;
+  return isRaw && layout.chunkShape.size() == static_cast<size_t>(store.rank());
 }
 
+// Calls `visit` with each index of the half-open box [begin, end), in C order.
+template <typename TVisitor>
 void
-addCoordinateTransformations(OMEZarrNGFFImageIO * io, nlohmann::json ct)
+ForEachIndex(const std::vector<tensorstore::Index> & begin,
+             const std::vector<tensorstore::Index> & end,
+             TVisitor &&                             visit)
 {
-  itkAssertOrThrowMacro(ct.is_array(), "Failed to parse coordinate transforms");
-  itkAssertOrThrowMacro(ct.size() >= 1, "Expected at least one coordinate transform");
-  itkAssertOrThrowMacro(ct[0].at("type") == "scale",
-                        ("Expected first transform to be \"scale\" but found " +
-                         std::string(ct[0].at("type")))); // first transformation must be scale
-
-  nlohmann::json s = ct[0].at("scale");
-  itkAssertOrThrowMacro(s.is_array(), "Failed to parse scale transform");
-  unsigned dim = s.size();
-  itkAssertOrThrowMacro(dim == io->GetNumberOfDimensions(), "Found dimension mismatch in scale transform");
-
-  for (unsigned d = 0; d < dim; ++d)
+  const size_t rank = begin.size();
+  for (size_t dim = 0; dim < rank; ++dim)
   {
-    double dS = s[dim - d - 1].get<double>(); // reverse indices KJI into IJK
-    io->SetSpacing(d, dS * io->GetSpacing(d));
-    io->SetOrigin(d, dS * io->GetOrigin(d)); // TODO: should we update origin like this?
+    if (begin[dim] >= end[dim])
+    {
+      return;
+    }
   }
-
-  if (ct.size() > 1) // there is also a translation
+  std::vector<tensorstore::Index> index(begin);
+  while (true)
   {
-    itkAssertOrThrowMacro(ct[1].at("type") == "translation",
-                          ("Expected second transform to be \"translation\" but found " +
-                           std::string(ct[1].at("type")))); // first transformation must be scale
-    nlohmann::json tr = ct[1].at("translation");
-    itkAssertOrThrowMacro(tr.is_array(), "Failed to parse translation transform");
-    dim = tr.size();
-    itkAssertOrThrowMacro(dim == io->GetNumberOfDimensions(), "Found dimension mismatch in translation transform");
-
-    for (unsigned d = 0; d < dim; ++d)
+    visit(index);
+    size_t dim = rank;
+    while (dim > 0 && ++index[dim - 1] == end[dim - 1])
     {
-      double dOrigin = tr[dim - d - 1].get<double>(); // reverse indices KJI into IJK
-      io->SetOrigin(d, dOrigin + io->GetOrigin(d));
+      index[dim - 1] = begin[dim - 1];
+      --dim;
+    }
+    if (dim == 0)
+    {
+      return;
     }
   }
+}
 
-  if (ct.size() > 2)
+// Returns the store axis read into pixel components, if any, and the selection of channels
+// applied along it when they do not form a contiguous run.
+ComponentAxis
+FindComponentAxis(const OMEZarrNGFFImageIO::AxesCollectionType & storeAxes,
+                  bool                                           channelsAsComponents,
+                  const std::vector<IndexValueType> &            channelIndices)
+{
+  ComponentAxis componentAxis;
+  if (channelsAsComponents)
   {
-    itkGenericOutputMacro(<< "A sequence of more than 2 transformations is specified in '" << io->GetFileName()
-                          << "'. This is currently not supported. Extra transformations are ignored.");
+    for (size_t storeIndex = 0; storeIndex < storeAxes.size(); ++storeIndex)
+    {
+      if (storeAxes[storeIndex].name == "c")
+      {
+        componentAxis.storeIndex = storeIndex;
+      }
+    }
+    if (componentAxis.storeIndex >= 0 && !IsContiguousRun(channelIndices))
+    {
+      componentAxis.selection.assign(channelIndices.cbegin(), channelIndices.cend());
+    }
   }
+  return componentAxis;
 }
 
-} // namespace
-
-struct OMEZarrNGFFImageIO::TensorStoreData
+// Memory layout of a region read into a buffer, in store axis order. The component axis, if any,
+// is stored last, as the pixel components, with channels mapped through the selection.
+struct RegionBufferLayout
 {
-  tensorstore::Context       tsContext{ tensorstore::Context::Default() };
-  tensorstore::TensorStore<> store{};
+  std::vector<tensorstore::Index> origin;
+  std::vector<tensorstore::Index> shape;
+  std::vector<tensorstore::Index> strides; // in elements
+  ComponentAxis                   componentAxis;
 };
 
-OMEZarrNGFFImageIO::OMEZarrNGFFImageIO()
-  : m_TensorStoreData(std::make_unique<TensorStoreData>())
+RegionBufferLayout
+MakeRegionBufferLayout(const ImageIORegion & storeIORegion, const ComponentAxis & componentAxis)
 {
-  this->AddSupportedWriteExtension(".zarr");
-  this->AddSupportedWriteExtension(".zr2");
-  this->AddSupportedWriteExtension(".zr3");
-  this->AddSupportedWriteExtension(".zip");
-  this->AddSupportedWriteExtension(".memory");
-
-  this->AddSupportedReadExtension(".zarr");
-  this->AddSupportedReadExtension(".zr2");
-  this->AddSupportedReadExtension(".zr3");
-  this->AddSupportedReadExtension(".zip");
-  this->AddSupportedWriteExtension(".memory");
+  const auto         rank = static_cast<tensorstore::DimensionIndex>(storeIORegion.GetImageDimension());
+  RegionBufferLayout layout{ std::vector<tensorstore::Index>(rank),
+                             std::vector<tensorstore::Index>(rank),
+                             std::vector<tensorstore::Index>(rank),
+                             componentAxis };
+  for (tensorstore::DimensionIndex dim = 0; dim < rank; ++dim)
+  {
+    layout.origin[dim] = storeIORegion.GetIndex(dim);
+    layout.shape[dim] = storeIORegion.GetSize(dim);
+  }
 
-  this->Self::SetCompressor("");
-  this->Self::SetMaximumCompressionLevel(9);
-  this->Self::SetCompressionLevel(2);
+  tensorstore::Index stride = 1;
+  if (componentAxis.storeIndex >= 0)
+  {
+    layout.strides[componentAxis.storeIndex] = 1;
+    stride = componentAxis.selection.empty() ? layout.shape[componentAxis.storeIndex]
+                                             : static_cast<tensorstore::Index>(componentAxis.selection.size());
+  }
+  for (tensorstore::DimensionIndex dim = rank - 1; dim >= 0; --dim)
+  {
+    if (dim != componentAxis.storeIndex)
+    {
+      layout.strides[dim] = stride;
+      stride *= layout.shape[dim];
+    }
+  }
+  return layout;
 }
 
-OMEZarrNGFFImageIO::~OMEZarrNGFFImageIO() = default;
-
-
+// Copies `count` elements of a fixed size between strided runs, as moves rather than `memcpy` calls.
+template <size_t ElementSize>
 void
-OMEZarrNGFFImageIO::PrintSelf(std::ostream & os, Indent indent) const
+CopyStridedElements(char *                   output,
+                    const tensorstore::Index outputStride,
+                    const char *             input,
+                    const tensorstore::Index inputStride,
+                    const tensorstore::Index count)
 {
-  Superclass::PrintSelf(os, indent);
-  os << indent << "DatasetIndex: " << m_DatasetIndex << std::endl;
-  os << indent << "TimeIndex: " << m_TimeIndex << std::endl;
-  os << indent << "ChannelIndex: " << m_ChannelIndex << std::endl;
+  for (tensorstore::Index i = 0; i < count; ++i)
+  {
+    std::memcpy(output + i * outputStride, input + i * inputStride, ElementSize);
+  }
 }
 
-bool
-OMEZarrNGFFImageIO::CanReadFile(const char * filename)
+// Copies a run of `count` elements between buffers with the given byte strides.
+void
+CopyStridedRun(char *                   output,
+               const tensorstore::Index outputStride,
+               const char *             input,
+               const tensorstore::Index inputStride,
+               const tensorstore::Index count,
+               const tensorstore::Index elementSize)
 {
-  try
+  if (outputStride == elementSize && inputStride == elementSize)
   {
-    std::string    driver = getKVstoreDriver(filename);
-    nlohmann::json json;
-    if (!jsonRead(std::string(filename) + "/.zgroup", json, driver, m_TensorStoreData->tsContext))
-    {
-      return false;
-    }
-    if (json.at("zarr_format").get<int>() != 2)
-    {
-      return false; // unsupported zarr format
-    }
-    if (!jsonRead(std::string(filename) + "/.zattrs", json, driver, m_TensorStoreData->tsContext))
-    {
-      return false;
-    }
-    if (!json.at("multiscales").is_array())
-    {
-      return false; // multiscales attribute array must be present
-    }
-    return true;
+    std::memcpy(output, input, count * elementSize);
+    return;
   }
-  catch (...)
+  switch (elementSize)
   {
-    return false;
+    case 1:
+      CopyStridedElements<1>(output, outputStride, input, inputStride, count);
+      break;
+    case 2:
+      CopyStridedElements<2>(output, outputStride, input, inputStride, count);
+      break;
+    case 4:
+      CopyStridedElements<4>(output, outputStride, input, inputStride, count);
+      break;
+    case 8:
+      CopyStridedElements<8>(output, outputStride, input, inputStride, count);
+      break;
+    default:
+      for (tensorstore::Index i = 0; i < count; ++i)
+      {
+        std::memcpy(output + i * outputStride, input + i * inputStride, elementSize);
+      }
   }
-  // return this->HasSupportedWriteExtension(filename, true);
 }
 
+// Copies the part of a chunk, read as an array with the given origin, which overlaps a region into its buffer.
 void
-OMEZarrNGFFImageIO::ReadArrayMetadata(std::string path, std::string driver)
+CopyChunkToRegion(const tensorstore::SharedArray<const void> & chunk,
+                  const std::vector<tensorstore::Index> &      chunkOrigin,
+                  const RegionBufferLayout &                   layout,
+                  void *                                       buffer)
 {
-  nlohmann::json readSpec = { { "driver", "zarr" }, { "kvstore", { { "driver", driver }, { "path", path } } } };
-  if (driver == "http")
+  const auto                      rank = chunk.rank();
+  const auto                      elementSize = static_cast<tensorstore::Index>(chunk.dtype().size());
+  std::vector<tensorstore::Index> begin(rank);
+  std::vector<tensorstore::Index> end(rank);
+  for (tensorstore::DimensionIndex dim = 0; dim < rank; ++dim)
   {
-    MakeKVStoreHTTPDriverSpec(readSpec, path);
+    begin[dim] = std::max(chunkOrigin[dim], layout.origin[dim]);
+    end[dim] = std::min(chunkOrigin[dim] + chunk.shape()[dim], layout.origin[dim] + layout.shape[dim]);
+    if (begin[dim] >= end[dim])
+    {
+      return;
+    }
   }
 
-  auto openFuture = tensorstore::Open(readSpec,
-                                      m_TensorStoreData->tsContext,
-                                      tensorstore::OpenMode::open,
-                                      tensorstore::RecheckCached{ false },
-                                      tensorstore::ReadWriteMode::read);
-  TS_EVAL_CHECK(openFuture);
-  m_TensorStoreData->store = openFuture.value();
-  auto shape_span = m_TensorStoreData->store.domain().shape();
-
-  tensorstore::DataType dtype = m_TensorStoreData->store.dtype();
-  this->SetComponentType(tensorstoreToITKComponentType(dtype));
-
-  std::vector<int64_t> dims(shape_span.rbegin(), shape_span.rend()); // convert KJI into IJK
-
-  if (this->GetNumberOfDimensions() == 0) // reading version 0.2 or 0.1
-  {
-    this->InitializeIdentityMetadata(dims.size());
-  }
-  else
+  // Output components of each channel of the chunk
+  const auto                                                    componentDim = layout.componentAxis.storeIndex;
+  std::map<tensorstore::Index, std::vector<tensorstore::Index>> componentsOfChannel;
+  if (componentDim >= 0)
   {
-    itkAssertOrThrowMacro(this->GetNumberOfDimensions() == dims.size(), "Found dimension mismatch in metadata");
-  }
-
-  for (unsigned d = 0; d < dims.size(); ++d)
+    for (tensorstore::Index channel = begin[componentDim]; channel < end[componentDim]; ++channel)
+    {
+      if (layout.componentAxis.selection.empty())
+      {
+        componentsOfChannel[channel].push_back(channel - layout.origin[componentDim]);
+      }
+      for (size_t component = 0; component < layout.componentAxis.selection.size(); ++component)
+      {
+        if (layout.componentAxis.selection[component] == channel)
+        {
+          componentsOfChannel[channel].push_back(component);
+        }
+      }
+    }
+  }
+
+  // Copy runs along the fastest varying axis, which are strided in the buffer when components are interleaved
+  const auto   lastDim = rank - 1;
+  const auto   runLength = end[lastDim] - begin[lastDim];
+  const auto * input = static_cast<const char *>(chunk.data());
+  auto *       output = static_cast<char *>(buffer);
+  auto         runEnd = end;
+  runEnd[lastDim] = begin[lastDim] + 1;
+  ForEachIndex(begin, runEnd, [&](const std::vector<tensorstore::Index> & index) {
+    tensorstore::Index inputOffset = 0; // in bytes
+    tensorstore::Index outputOffset = 0;
+    for (tensorstore::DimensionIndex dim = 0; dim < rank; ++dim)
+    {
+      inputOffset += (index[dim] - chunkOrigin[dim]) * chunk.byte_strides()[dim];
+      if (dim != componentDim)
+      {
+        outputOffset += (index[dim] - layout.origin[dim]) * layout.strides[dim];
+      }
+    }
+    const auto copyRun = [&](tensorstore::Index runOutputOffset) {
+      CopyStridedRun(output + runOutputOffset * elementSize,
+                     layout.strides[lastDim] * elementSize,
+                     input + inputOffset,
+                     chunk.byte_strides()[lastDim],
+                     runLength,
+                     elementSize);
+    };
+    if (componentDim < 0)
+    {
+      copyRun(outputOffset);
+    }
+    else if (componentDim == lastDim)
+    {
+      // Each channel of the run goes to its own components
+      for (tensorstore::Index i = 0; i < runLength; ++i)
+      {
+        for (const auto component : componentsOfChannel[begin[lastDim] + i])
+        {
+          std::memcpy(output + (outputOffset + component) * elementSize,
+                      input + inputOffset + i * chunk.byte_strides()[lastDim],
+                      elementSize);
+        }
+      }
+    }
+    else
+    {
+      for (const auto component : componentsOfChannel[index[componentDim]])
+      {
+        copyRun(outputOffset + component);
+      }
+    }
+  });
+}
+
+// Image information of a resolution level, or why it could not be determined.
+struct DatasetGeometry
+{
+  std::vector<SizeValueType> dimensions;
+  std::vector<double>        spacing;
+  std::vector<double>        origin;
+  std::string                error;
+  bool                       recorded{ false }; // whether the level was read, successfully or not
+  std::string                settings{};        // time and channel settings it was read with
+};
+
+// Returns the settings which the image information of a resolution level depends on, besides its metadata.
+std::string
+MakeGeometrySettings(const OMEZarrNGFFImageIO & io)
+{
+  std::ostringstream settings;
+  settings << io.GetTimeAsDimension() << ' ' << io.GetTimeIndex() << ' ' << io.GetNumberOfTimePoints() << ' '
+           << io.GetChannelsAsComponents();
+  for (const auto channelIndex : io.GetChannelIndices())
+  {
+    settings << ' ' << channelIndex;
+  }
+  return settings.str();
+}
+
+// Returns whether the image information of a resolution level was read with the current settings of the image IO.
+bool
+IsGeometryRecorded(const DatasetGeometry & geometry, const OMEZarrNGFFImageIO & io)
+{
+  return geometry.recorded && geometry.settings == MakeGeometrySettings(io);
+}
+
+// Returns the image information which the image IO currently holds.
+DatasetGeometry
+MakeDatasetGeometry(const OMEZarrNGFFImageIO & io)
+{
+  DatasetGeometry geometry;
+  for (unsigned d = 0; d < io.GetNumberOfDimensions(); ++d)
+  {
+    geometry.dimensions.push_back(io.GetDimensions(d));
+    geometry.spacing.push_back(io.GetSpacing(d));
+    geometry.origin.push_back(io.GetOrigin(d));
+  }
+  geometry.recorded = true;
+  geometry.settings = MakeGeometrySettings(io);
+  return geometry;
+}
+
+// Returns the image information of a resolution level, or throws why it could not be determined.
+const DatasetGeometry &
+GetDatasetGeometry(const std::vector<DatasetGeometry> & geometries, unsigned datasetIndex)
+{
+  if (datasetIndex >= geometries.size())
+  {
+    itkGenericExceptionMacro(<< "Requested DatasetIndex of " << datasetIndex
+                             << " is out of range for the number of datasets (" << geometries.size() << ")");
+  }
+  const auto & geometry = geometries[datasetIndex];
+  if (!geometry.error.empty())
+  {
+    itkGenericExceptionMacro(<< "Failed to read resolution level " << datasetIndex << ": " << geometry.error);
+  }
+  return geometry;
+}
+
+// Read-only memory mapping of a whole file, which is unmapped when destroyed. Holds no
+// mapping if the file cannot be mapped, e.g. if it is missing or on platforms without mmap.
+struct MappedFile
+{
+  const char * data{ nullptr };
+  size_t       size{ 0 };
+
+  explicit MappedFile(const std::string & path)
+  {
+#ifndef _WIN32
+    const int descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+      return;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+    {
+      void * mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+      if (mapping != MAP_FAILED)
+      {
+        data = static_cast<const char *>(mapping);
+        size = static_cast<size_t>(status.st_size);
+        // Chunks are copied front to back, and the kernel may read the following ones meanwhile
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        madvise(mapping, size, MADV_WILLNEED);
+      }
+    }
+    close(descriptor);
+#endif
+  }
+
+  ~MappedFile()
+  {
+#ifndef _WIN32
+    if (data != nullptr)
+    {
+      munmap(const_cast<char *>(data), size);
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &
+  operator=(const MappedFile &) = delete;
+};
+
+// Returns the local directory holding the chunk files of the store, with a trailing separator,
+// or an empty string if its chunks are not stored as local files which can be memory mapped.
+std::string
+GetLocalChunkDirectory(const tensorstore::TensorStore<> & store)
+{
+#ifdef _WIN32
+  (void)store;
+  return {};
+#else
+  const auto kvstore = store.kvstore();
+  if (!kvstore.valid())
+  {
+    return {};
+  }
+  auto spec = kvstore.spec();
+  if (!spec.ok())
+  {
+    return {};
+  }
+  auto specJson = spec->ToJson();
+  if (!specJson.ok() || specJson->value("driver", "") != "file" || !specJson->contains("path"))
+  {
+    return {};
+  }
+  std::string directory = specJson->at("path").get<std::string>();
+  if (!directory.empty() && directory.back() != '/')
+  {
+    directory += '/';
+  }
+  return directory;
+#endif
+}
+
+// Gets the chunk grid range [gridBegin, gridEnd) covered by a store IO region. Returns false if the
+// region is not chunk-aligned, where chunks at the end of the store may extend beyond the region.
+bool
+GetRawChunkGridRange(const RawChunkLayout &                            layout,
+                     const tensorstore::span<const tensorstore::Index> storeShape,
+                     const ImageIORegion &                             storeIORegion,
+                     std::vector<tensorstore::Index> &                 gridBegin,
+                     std::vector<tensorstore::Index> &                 gridEnd)
+{
+  const size_t rank = storeIORegion.GetImageDimension();
+  gridBegin.resize(rank);
+  gridEnd.resize(rank);
+  for (size_t dim = 0; dim < rank; ++dim)
+  {
+    const tensorstore::Index chunkSize = layout.chunkShape[dim];
+    const tensorstore::Index begin = storeIORegion.GetIndex(dim);
+    const tensorstore::Index end = begin + static_cast<tensorstore::Index>(storeIORegion.GetSize(dim));
+    if (chunkSize <= 0 || begin % chunkSize != 0 || (end % chunkSize != 0 && end != storeShape[dim]))
+    {
+      return false;
+    }
+    gridBegin[dim] = begin / chunkSize;
+    gridEnd[dim] = (end + chunkSize - 1) / chunkSize;
+  }
+  return true;
+}
+
+// Returns the key of the chunk at a chunk grid index, e.g. "0.2.1" or "c/0/2/1"
+std::string
+MakeRawChunkKey(const RawChunkLayout & layout, const std::vector<tensorstore::Index> & gridIndex)
+{
+  std::string key = layout.keyPrefix;
+  for (size_t dim = 0; dim < gridIndex.size(); ++dim)
+  {
+    key += (dim > 0 ? layout.separator : "") + std::to_string(gridIndex[dim]);
+  }
+  return key;
+}
+
+// Advises the kernel that the local chunk files of a chunk-aligned store IO region are about to be read,
+// so that they are read into the page cache in the background.
+void
+AdviseRawChunks(const tensorstore::TensorStore<> & store,
+                const RawChunkLayout &             layout,
+                const std::string &                chunkDirectory,
+                const ImageIORegion &              storeIORegion)
+{
+#ifndef _WIN32
+  std::vector<tensorstore::Index> gridBegin;
+  std::vector<tensorstore::Index> gridEnd;
+  if (!GetRawChunkGridRange(layout, store.domain().shape(), storeIORegion, gridBegin, gridEnd))
+  {
+    return;
+  }
+  ForEachIndex(gridBegin, gridEnd, [&](const std::vector<tensorstore::Index> & gridIndex) {
+    const int descriptor = open((chunkDirectory + MakeRawChunkKey(layout, gridIndex)).c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor >= 0)
+    {
+      posix_fadvise(descriptor, 0, 0, POSIX_FADV_WILLNEED);
+      close(descriptor);
+    }
+  });
+#endif
+}
+
+// Amount of data handled by a raw chunk read.
+struct RawChunkReadInfo
+{
+  size_t chunks{ 0 };
+  size_t bytes{ 0 };
+  double copySeconds{ 0.0 };
+};
+
+// Reads a chunk-aligned store IO region by copying raw chunk bytes straight into the buffer,
+// which skips chunk decoding and the chunk cache. Returns false without modifying the buffer
+// if the region is not chunk-aligned or a chunk is missing or has an unexpected size, in which
+// case the region must be read through tensorstore, e.g. to apply the fill value.
+// If `mappedChunkDirectory` is not empty, chunks are copied from memory mappings of the chunk
+// files in that directory rather than read through the kvstore of the store.
+bool
+ReadRawChunks(const tensorstore::TensorStore<> & store,
+              const RawChunkLayout &             layout,
+              const ImageIORegion &              storeIORegion,
+              void *                             buffer,
+              RawChunkReadInfo &                 info,
+              const std::string &                mappedChunkDirectory = {})
+{
+  const size_t                    rank = store.rank();
+  std::vector<tensorstore::Index> begin(rank);
+  std::vector<tensorstore::Index> end(rank);
+  std::vector<tensorstore::Index> gridBegin;
+  std::vector<tensorstore::Index> gridEnd;
+  if (!GetRawChunkGridRange(layout, store.domain().shape(), storeIORegion, gridBegin, gridEnd))
+  {
+    return false;
+  }
+  for (size_t dim = 0; dim < rank; ++dim)
+  {
+    begin[dim] = storeIORegion.GetIndex(dim);
+    end[dim] = begin[dim] + static_cast<tensorstore::Index>(storeIORegion.GetSize(dim));
+  }
+
+  std::vector<std::vector<tensorstore::Index>> chunkIndices;
+  std::vector<std::string>                     chunkKeys;
+  ForEachIndex(gridBegin, gridEnd, [&](const std::vector<tensorstore::Index> & gridIndex) {
+    chunkIndices.push_back(gridIndex);
+    chunkKeys.push_back(MakeRawChunkKey(layout, gridIndex));
+  });
+
+  const size_t elementSize = store.dtype().size();
+  size_t       chunkBytes = elementSize;
+  for (const auto chunkSize : layout.chunkShape)
+  {
+    chunkBytes *= chunkSize;
+  }
+  std::vector<const char *>                chunkData;
+  std::vector<absl::Cord>                  chunks;
+  std::vector<std::unique_ptr<MappedFile>> mappedChunks;
+  if (!mappedChunkDirectory.empty())
+  {
+    // Map all chunks at once, so that the kernel reads them ahead while earlier chunks are copied
+    for (const auto & key : chunkKeys)
+    {
+      mappedChunks.push_back(std::make_unique<MappedFile>(mappedChunkDirectory + key));
+      if (mappedChunks.back()->size != chunkBytes)
+      {
+        return false;
+      }
+      chunkData.push_back(mappedChunks.back()->data);
+    }
+  }
+  else
+  {
+    // Fetch all chunks concurrently
+    const auto kvstore = store.kvstore();
+    if (!kvstore.valid())
+    {
+      return false;
+    }
+    std::vector<tensorstore::Future<tensorstore::kvstore::ReadResult>> chunkReads;
+    for (const auto & key : chunkKeys)
+    {
+      chunkReads.push_back(tensorstore::kvstore::Read(kvstore, key));
+    }
+    for (auto & chunkRead : chunkReads)
+    {
+      const auto & result = chunkRead.result();
+      if (!result.ok() || !result->has_value() || result->value.size() != chunkBytes)
+      {
+        return false;
+      }
+      chunks.push_back(result->value);
+    }
+    for (auto & chunk : chunks)
+    {
+      chunkData.push_back(chunk.Flatten().data());
+    }
+  }
+
+  // Copy contiguous runs along the fastest moving axis
+  std::vector<tensorstore::Index> chunkStrides(rank, 1);
+  std::vector<tensorstore::Index> regionStrides(rank, 1);
+  for (size_t dim = rank - 1; dim > 0; --dim)
+  {
+    chunkStrides[dim - 1] = chunkStrides[dim] * layout.chunkShape[dim];
+    regionStrides[dim - 1] = regionStrides[dim] * (end[dim] - begin[dim]);
+  }
+  const auto copyStart = std::chrono::steady_clock::now();
+  auto *     output = static_cast<char *>(buffer);
+  for (size_t chunk = 0; chunk < chunkData.size(); ++chunk)
+  {
+    const char *                    input = chunkData[chunk];
+    std::vector<tensorstore::Index> chunkOrigin(rank);
+    std::vector<tensorstore::Index> copyBegin(rank);
+    std::vector<tensorstore::Index> copyEnd(rank);
+    for (size_t dim = 0; dim < rank; ++dim)
+    {
+      chunkOrigin[dim] = chunkIndices[chunk][dim] * layout.chunkShape[dim];
+      copyBegin[dim] = chunkOrigin[dim];
+      copyEnd[dim] = std::min(chunkOrigin[dim] + layout.chunkShape[dim], end[dim]);
+    }
+    const size_t runBytes = (copyEnd[rank - 1] - copyBegin[rank - 1]) * elementSize;
+    copyEnd[rank - 1] = copyBegin[rank - 1] + 1;
+    ForEachIndex(copyBegin, copyEnd, [&](const std::vector<tensorstore::Index> & index) {
+      tensorstore::Index inputOffset = 0;
+      tensorstore::Index outputOffset = 0;
+      for (size_t dim = 0; dim < rank; ++dim)
+      {
+        inputOffset += (index[dim] - chunkOrigin[dim]) * chunkStrides[dim];
+        outputOffset += (index[dim] - begin[dim]) * regionStrides[dim];
+      }
+      std::memcpy(output + outputOffset * elementSize, input + inputOffset * elementSize, runBytes);
+    });
+  }
+  info.chunks = chunkData.size();
+  info.bytes = chunkData.size() * chunkBytes;
+  info.copySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - copyStart).count();
+  return true;
+}
+
+// Names of the read statistics, in enumeration order.
+const std::vector<std::string> readStatisticNames = { "ChunksRequested", "ChunksFromCache", "BytesFetched",
+                                                      "BytesDecoded",    "HTTPRequests",    "KVStoreSeconds",
+                                                      "CopySeconds",     "TotalSeconds" };
+
+// Totals of the process-wide tensorstore metrics which read statistics are derived from. A total is
+// unset if its metric is not registered, e.g. because a tensorstore version renamed it.
+struct TensorstoreMetrics
+{
+  std::optional<double> kvstoreReads{};            // "/tensorstore/kvstore/<driver>/read" of all drivers
+  std::optional<double> kvstoreBytesRead{};        // "/tensorstore/kvstore/<driver>/bytes_read" of all drivers
+  std::optional<double> kvstoreReadMilliseconds{}; // "/tensorstore/kvstore/<driver>/read_latency_ms" of all drivers
+  std::optional<double> httpRequests{};            // "/tensorstore/http/request_started"
+};
+
+// Collects the tensorstore metrics used for read statistics. This is the only user of tensorstore's
+// internal metrics registry, whose API and metric names are not stable. Counters are summed over
+// their fields, and histograms give the sum of their samples. Without the registry, which the build
+// checks for, all totals are unset.
+TensorstoreMetrics
+CollectTensorstoreMetrics()
+{
+#ifndef ITK_OMEZARRNGFF_HAVE_TENSORSTORE_METRICS
+  return {};
+#else
+  const std::string  kvstorePrefix = "/tensorstore/kvstore/";
+  TensorstoreMetrics metrics;
+  for (const auto & metric : tensorstore::internal_metrics::GetMetricRegistry().CollectWithPrefix("/tensorstore/"))
+  {
+    double total = 0.0;
+    for (const auto & value : metric.values)
+    {
+      std::visit(
+        [&total](const auto & v) {
+          if constexpr (std::is_arithmetic_v<std::decay_t<decltype(v)>>)
+          {
+            total += static_cast<double>(v);
+          }
+        },
+        value.value);
+    }
+    for (const auto & histogram : metric.histograms)
+    {
+      total += histogram.count * histogram.mean;
+    }
+
+    const std::string       name(metric.metric_name);
+    std::optional<double> * sum = nullptr;
+    if (name == "/tensorstore/http/request_started")
+    {
+      sum = &metrics.httpRequests;
+    }
+    else if (name.compare(0, kvstorePrefix.size(), kvstorePrefix) == 0)
+    {
+      // The metric name without its prefix is "<driver>/<name>"
+      const size_t separator = name.find('/', kvstorePrefix.size());
+      const auto   suffix = separator == std::string::npos ? std::string() : name.substr(separator + 1);
+      sum = suffix == "read"              ? &metrics.kvstoreReads
+            : suffix == "bytes_read"      ? &metrics.kvstoreBytesRead
+            : suffix == "read_latency_ms" ? &metrics.kvstoreReadMilliseconds
+                                          : nullptr;
+    }
+    if (sum != nullptr)
+    {
+      *sum = sum->value_or(0.0) + total;
+    }
+  }
+  return metrics;
+#endif
+}
+
+// Returns the change of a metric total, or nothing if the metric is not registered.
+std::optional<double>
+MetricDelta(const std::optional<double> & before, const std::optional<double> & after)
+{
+  if (!after)
+  {
+    return std::nullopt;
+  }
+  return *after - before.value_or(0.0);
+}
+
+// Returns the number of chunks of the store overlapping a store IO region.
+size_t
+CountChunks(const tensorstore::TensorStore<> & store, const ImageIORegion & storeIORegion)
+{
+  const auto chunkShape = GetChunkShape(store);
+  size_t     chunks = 1;
+  for (size_t dim = 0; dim < chunkShape.size(); ++dim)
+  {
+    if (storeIORegion.GetSize(dim) == 0)
+    {
+      return 0;
+    }
+    const tensorstore::Index begin = storeIORegion.GetIndex(dim);
+    const tensorstore::Index last = begin + static_cast<tensorstore::Index>(storeIORegion.GetSize(dim)) - 1;
+    chunks *= last / chunkShape[dim] - begin / chunkShape[dim] + 1;
+  }
+  return chunks;
+}
+
+// Compressor names accepted by `SetCompressor`, in addition to the empty default.
+// "BLOSC" is an alias for "BLOSC_LZ4", which is also used by default.
+const std::vector<std::string> supportedCompressors = { "BLOSC", "BLOSC_LZ4", "BLOSC_ZSTD", "BLOSC_BLOSCLZ",
+                                                        "ZSTD",  "GZIP",      "NONE" };
+
+// Returns the zarr v2 "compressor" metadata for the specified ITK compressor name and level.
+// Blosc shuffles bits for 1- and 2-byte components and bytes for wider components.
+nlohmann::json
+MakeZarrCompressor(const std::string & compressor, const int compressionLevel, const unsigned componentSize)
+{
+  if (compressor == "NONE")
+  {
+    return nullptr;
+  }
+  if (compressor == "ZSTD")
+  {
+    return { { "id", "zstd" }, { "level", compressionLevel } };
+  }
+  if (compressor == "GZIP")
+  {
+    return { { "id", "gzip" }, { "level", compressionLevel } };
+  }
+
+  std::string cname = "lz4";
+  if (compressor == "BLOSC_ZSTD")
+  {
+    cname = "zstd";
+  }
+  else if (compressor == "BLOSC_BLOSCLZ")
+  {
+    cname = "blosclz";
+  }
+  constexpr int byteShuffle = 1;
+  constexpr int bitShuffle = 2;
+  return { { "id", "blosc" },
+           { "cname", cname },
+           { "clevel", compressionLevel },
+           { "shuffle", componentSize <= 2 ? bitShuffle : byteShuffle },
+           { "blocksize", 0 } };
+}
+
+// Returns the zarr v3 "codecs" metadata for the specified ITK compressor name and level.
+// Chunks are encoded as bytes in native endianness, followed by the same codec as in zarr v2.
+nlohmann::json
+MakeZarr3Codecs(const std::string & compressor, const int compressionLevel, const unsigned componentSize)
+{
+  nlohmann::json bytesCodec = { { "name", "bytes" } };
+  if (componentSize > 1)
+  {
+    bytesCodec["configuration"] = { { "endian", ByteSwapper<int>::SystemIsBigEndian() ? "big" : "little" } };
+  }
+  nlohmann::json codecs = nlohmann::json::array({ bytesCodec });
+
+  const nlohmann::json v2Compressor = MakeZarrCompressor(compressor, compressionLevel, componentSize);
+  if (v2Compressor.is_null())
+  {
+    return codecs;
+  }
+  const std::string id = v2Compressor.at("id");
+  if (id == "blosc")
+  {
+    codecs.push_back({ { "name", "blosc" },
+                       { "configuration",
+                         { { "cname", v2Compressor.at("cname") },
+                           { "clevel", compressionLevel },
+                           { "shuffle", v2Compressor.at("shuffle") == 2 ? "bitshuffle" : "shuffle" },
+                           { "typesize", componentSize },
+                           { "blocksize", 0 } } } });
+  }
+  else if (id == "zstd")
+  {
+    codecs.push_back(
+      { { "name", "zstd" }, { "configuration", { { "level", compressionLevel }, { "checksum", false } } } });
+  }
+  else
+  {
+    codecs.push_back({ { "name", id }, { "configuration", { { "level", compressionLevel } } } });
+  }
+  return codecs;
+}
+
+// Returns the chunk shape for a new array in tensorstore (C-style) axis order.
+// A non-empty requested chunk shape is given in ITK axis order, where zero entries span the full extent.
+// Otherwise the chunk shape targets the given number of uncompressed bytes per chunk:
+// channel and time axes are chunked one element at a time, while the element budget is
+// spread over the spatial axes as isotropically as their extents allow.
+std::vector<int64_t>
+MakeChunkShape(const std::vector<SizeValueType> & requestedChunkShape,
+               const std::vector<int64_t> &       storeShape,
+               const std::vector<std::string> &   storeAxisNames,
+               const SizeValueType                bytesPerElement,
+               const SizeValueType                targetChunkSizeInBytes)
+{
+  const size_t         rank = storeShape.size();
+  std::vector<int64_t> chunkShape(rank, 1);
+  if (!requestedChunkShape.empty())
+  {
+    if (requestedChunkShape.size() != rank)
+    {
+      itkGenericExceptionMacro("Chunk shape has " << requestedChunkShape.size() << " elements but the image has "
+                                                  << rank << " dimensions");
+    }
+    for (size_t storeIndex = 0; storeIndex < rank; ++storeIndex)
+    {
+      const auto requested = static_cast<int64_t>(requestedChunkShape[rank - 1 - storeIndex]); // convert IJK into KJI
+      chunkShape[storeIndex] = (requested == 0) ? storeShape[storeIndex] : std::min(requested, storeShape[storeIndex]);
+      chunkShape[storeIndex] = std::max<int64_t>(chunkShape[storeIndex], 1);
+    }
+    return chunkShape;
+  }
+
+  // Distribute the budget starting with the smallest spatial axes, so that
+  // the remainder is carried over to the larger axes when an extent is exhausted.
+  std::vector<size_t> spatialIndices;
+  for (size_t storeIndex = 0; storeIndex < rank; ++storeIndex)
+  {
+    if (GetSpatialITKAxis(storeAxisNames[storeIndex]) >= 0)
+    {
+      spatialIndices.push_back(storeIndex);
+    }
+  }
+  std::sort(spatialIndices.begin(), spatialIndices.end(), [&storeShape](size_t a, size_t b) {
+    return storeShape[a] < storeShape[b];
+  });
+
+  double elementBudget =
+    std::max(1.0, static_cast<double>(targetChunkSizeInBytes) / std::max<SizeValueType>(bytesPerElement, 1));
+  for (size_t k = 0; k < spatialIndices.size(); ++k)
+  {
+    const size_t  storeIndex = spatialIndices[k];
+    const double  side = std::floor(std::pow(elementBudget, 1.0 / (spatialIndices.size() - k)) + 1e-6);
+    const int64_t extent = std::max<int64_t>(storeShape[storeIndex], 1);
+    const int64_t chunkSize = std::clamp<int64_t>(static_cast<int64_t>(side), 1, extent);
+    chunkShape[storeIndex] = chunkSize;
+    elementBudget /= chunkSize;
+  }
+  return chunkShape;
+}
+
+// Returns the shard shape for a new zarr v3 array in tensorstore (C-style) axis order.
+// The requested shard shape is given in ITK axis order, where zero entries span the full extent.
+// Shards are clamped to the extent and rounded up to hold a whole number of chunks.
+std::vector<int64_t>
+MakeShardShape(const std::vector<SizeValueType> & requestedShardShape,
+               const std::vector<int64_t> &       storeShape,
+               const std::vector<int64_t> &       chunkShape)
+{
+  const size_t rank = storeShape.size();
+  if (requestedShardShape.size() != rank)
+  {
+    itkGenericExceptionMacro("Shard shape has " << requestedShardShape.size() << " elements but the image has "
+                                                << rank << " dimensions");
+  }
+  std::vector<int64_t> shardShape(rank);
+  for (size_t storeIndex = 0; storeIndex < rank; ++storeIndex)
+  {
+    const auto    requested = static_cast<int64_t>(requestedShardShape[rank - 1 - storeIndex]); // convert IJK into KJI
+    const int64_t shardSize = (requested == 0) ? storeShape[storeIndex] : std::min(requested, storeShape[storeIndex]);
+    const int64_t chunkSize = chunkShape[storeIndex];
+    shardShape[storeIndex] = std::max<int64_t>((shardSize + chunkSize - 1) / chunkSize, 1) * chunkSize;
+  }
+  return shardShape;
+}
+
+// Returns the downsampling factors between consecutive resolution levels in store order.
+// Only spatial axes are downsampled.
+std::vector<tensorstore::Index>
+MakeDownsampleFactors(const std::vector<std::string> & storeAxisNames)
+{
+  std::vector<tensorstore::Index> factors(storeAxisNames.size(), 1);
+  for (size_t storeIndex = 0; storeIndex < storeAxisNames.size(); ++storeIndex)
+  {
+    if (GetSpatialITKAxis(storeAxisNames[storeIndex]) >= 0)
+    {
+      factors[storeIndex] = 2;
+    }
+  }
+  return factors;
+}
+
+tensorstore::DownsampleMethod
+ToTensorstoreDownsampleMethod(const OMEZarrNGFFImageIOEnums::DownsamplingMethod method)
+{
+  switch (method)
+  {
+    case OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mode:
+      return tensorstore::DownsampleMethod::kMode;
+    case OMEZarrNGFFImageIOEnums::DownsamplingMethod::Stride:
+      return tensorstore::DownsampleMethod::kStride;
+    case OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mean:
+    default:
+      return tensorstore::DownsampleMethod::kMean;
+  }
+}
+
+// Recomputes the part of each lower resolution level that depends on the given store region
+// of the first level. Each level is computed from the preceding level, which was just written,
+// so that its chunks are read from the cache pool of the context if they fit into it.
+// Blocks straddling the region bounds are recomputed when the neighboring region is written.
+// `levelDownsampleFactors[level - 1]` holds the factors from level `level - 1` to level `level`.
+void
+PropagateToResolutionLevels(const std::vector<tensorstore::TensorStore<>> &      levelStores,
+                            const ImageIORegion &                                storeIORegion,
+                            const std::vector<std::vector<tensorstore::Index>> & levelDownsampleFactors,
+                            const tensorstore::DownsampleMethod                  downsampleMethod)
+{
+  const size_t                    rank = storeIORegion.GetImageDimension();
+  std::vector<tensorstore::Index> begin(rank);
+  std::vector<tensorstore::Index> end(rank);
+  for (size_t dim = 0; dim < rank; ++dim)
+  {
+    begin[dim] = storeIORegion.GetIndex(dim);
+    end[dim] = begin[dim] + static_cast<tensorstore::Index>(storeIORegion.GetSize(dim));
+  }
+
+  for (size_t level = 1; level < levelStores.size(); ++level)
+  {
+    const auto & downsampleFactors = levelDownsampleFactors.at(level - 1);
+    auto downsampled = tensorstore::Downsample(levelStores[level - 1], downsampleFactors, downsampleMethod);
+    if (!downsampled.ok())
+    {
+      itkGenericExceptionMacro("tensorstore error: " << downsampled.status());
+    }
+
+    const auto levelShape = levelStores[level].domain().shape();
+    for (size_t dim = 0; dim < rank; ++dim)
+    {
+      begin[dim] = begin[dim] / downsampleFactors[dim];
+      end[dim] = std::min((end[dim] + downsampleFactors[dim] - 1) / downsampleFactors[dim], levelShape[dim]);
+    }
+
+    auto source = downsampled.value() | tensorstore::AllDims().HalfOpenInterval(begin, end);
+    auto target = levelStores[level] | tensorstore::AllDims().HalfOpenInterval(begin, end);
+    auto copyFuture = tensorstore::Copy(source, target);
+    TS_EVAL_CHECK(copyFuture);
+  }
+}
+
+// Returns the integer factors by which the coarser array was downsampled from the finer one, per store axis.
+// The smallest factor yielding the coarser shape is used, as larger ones pool the same elements.
+std::vector<tensorstore::Index>
+InferDownsampleFactors(const tensorstore::TensorStore<> & finer, const tensorstore::TensorStore<> & coarser)
+{
+  const auto finerShape = finer.domain().shape();
+  const auto coarserShape = coarser.domain().shape();
+  if (finerShape.size() != coarserShape.size())
+  {
+    itkGenericExceptionMacro("Resolution levels " << finer.domain() << " and " << coarser.domain()
+                                                  << " differ in their number of dimensions");
+  }
+  std::vector<tensorstore::Index> factors(finerShape.size());
+  for (size_t dim = 0; dim < factors.size(); ++dim)
+  {
+    const tensorstore::Index coarserSize = std::max<tensorstore::Index>(coarserShape[dim], 1);
+    factors[dim] = std::max<tensorstore::Index>((finerShape[dim] + coarserSize - 1) / coarserSize, 1);
+    if ((finerShape[dim] + factors[dim] - 1) / factors[dim] != coarserShape[dim])
+    {
+      itkGenericExceptionMacro("Resolution level " << coarser.domain() << " is not an integer downsampling of "
+                                                   << finer.domain());
+    }
+  }
+  return factors;
+}
+
+// Returns the factors between consecutive resolution levels, where element `level - 1` holds the factors
+// from level `level - 1` to level `level`. Throws if two levels are not related by integer factors.
+std::vector<std::vector<tensorstore::Index>>
+InferLevelDownsampleFactors(const std::vector<tensorstore::TensorStore<>> & levelStores)
+{
+  std::vector<std::vector<tensorstore::Index>> levelDownsampleFactors;
+  for (size_t level = 1; level < levelStores.size(); ++level)
+  {
+    levelDownsampleFactors.push_back(InferDownsampleFactors(levelStores[level - 1], levelStores[level]));
+  }
+  return levelDownsampleFactors;
+}
+
+// Returns the zarr format of a written store: the specified one, otherwise 3 for ".zr3" stores and 2 for others.
+unsigned
+ResolveZarrFormat(const unsigned zarrFormat, const std::string & fileName)
+{
+  if (zarrFormat != 0)
+  {
+    return zarrFormat;
+  }
+  return (fileName.size() >= 4 && fileName.substr(fileName.size() - 4) == ".zr3") ? 3 : 2;
+}
+
+// Returns why writing the store region, and propagating it as in `PropagateToResolutionLevels`,
+// could modify a chunk which other writers also modify, or an empty string if it cannot.
+// At each level the region must cover whole write chunks, and whole downsampling blocks
+// unless it is the last level. Only the last chunk or block along an axis may be partial.
+std::string
+DescribeUnsafeRegionWrite(const std::vector<tensorstore::TensorStore<>> &      levelStores,
+                          const ImageIORegion &                                storeIORegion,
+                          const std::vector<std::vector<tensorstore::Index>> & levelDownsampleFactors)
+{
+  const size_t                    rank = storeIORegion.GetImageDimension();
+  std::vector<tensorstore::Index> begin(rank);
+  std::vector<tensorstore::Index> end(rank);
+  for (size_t dim = 0; dim < rank; ++dim)
+  {
+    begin[dim] = storeIORegion.GetIndex(dim);
+    end[dim] = begin[dim] + static_cast<tensorstore::Index>(storeIORegion.GetSize(dim));
+  }
+
+  for (size_t level = 0; level < levelStores.size(); ++level)
+  {
+    const auto levelShape = levelStores[level].domain().shape();
+    if (level > 0)
+    {
+      const auto & downsampleFactors = levelDownsampleFactors.at(level - 1);
+      for (size_t dim = 0; dim < rank; ++dim)
+      {
+        begin[dim] = begin[dim] / downsampleFactors[dim];
+        end[dim] = std::min((end[dim] + downsampleFactors[dim] - 1) / downsampleFactors[dim], levelShape[dim]);
+      }
+    }
+
+    const auto chunkShape = GetChunkShape(levelStores[level], true);
+    for (size_t dim = 0; dim < rank; ++dim)
+    {
+      const bool         endsAtArrayEnd = end[dim] == levelShape[dim];
+      std::ostringstream description;
+      if (begin[dim] % chunkShape[dim] != 0 || (end[dim] % chunkShape[dim] != 0 && !endsAtArrayEnd))
+      {
+        description << "interval [" << begin[dim] << ", " << end[dim] << ") of store axis " << dim
+                    << " at resolution level " << level << " does not cover whole chunks of size " << chunkShape[dim];
+        return description.str();
+      }
+      if (level + 1 < levelStores.size())
+      {
+        const tensorstore::Index blockSize = levelDownsampleFactors.at(level)[dim];
+        if (begin[dim] % blockSize != 0 || (end[dim] % blockSize != 0 && !endsAtArrayEnd))
+        {
+          description << "interval [" << begin[dim] << ", " << end[dim] << ") of store axis " << dim
+                      << " at resolution level " << level << " does not cover whole downsampling blocks of size "
+                      << blockSize;
+          return description.str();
+        }
+      }
+    }
+  }
+  return {};
+}
+
+// Returns the zarr "dtype" string for the specified pixel type.
+template <typename TPixel>
+std::string
+MakeZarrDType()
+{
+  std::string dtype;
+  // we prefer to write using our own endianness, so no conversion is necessary
+  if (ByteSwapper<int>::SystemIsBigEndian())
+  {
+    dtype = ">";
+  }
+  else
+  {
+    dtype = "<";
+  }
+
+  if (sizeof(TPixel) == 1)
+  {
+    dtype = "|";
+  }
+  if (std::numeric_limits<TPixel>::is_integer)
+  {
+    if (std::numeric_limits<TPixel>::is_signed)
+    {
+      dtype += 'i';
+    }
+    else
+    {
+      dtype += 'u';
+    }
+  }
+  else
+  {
+    dtype += 'f';
+  }
+  dtype += std::to_string(sizeof(TPixel));
+  return dtype;
+}
+
+// Gets the zarr "dtype" string if the specified pixel type and the ITK component type match.
+template <typename TPixel>
+bool
+MakeZarrDTypeIfTypesMatch(const IOComponentEnum componentType, std::string & dtype)
+{
+  if (tensorstoreToITKComponentType(tensorstore::dtype_v<TPixel>) == componentType)
+  {
+    dtype = MakeZarrDType<TPixel>();
+    return true;
+  }
+  return false;
+}
+
+// Tries to get the zarr "dtype" string, trying any of the specified pixel types.
+template <typename... TPixel>
+bool
+TryToMakeZarrDType(TypeList<TPixel...>, const IOComponentEnum componentType, std::string & dtype)
+{
+  return (MakeZarrDTypeIfTypesMatch<TPixel>(componentType, dtype) || ...);
+}
+
+// Writes a buffered region into the corresponding store region.
+// As in `ReadFromStore`, the store IO region is expected to be in C-style order.
+template <typename TPixel>
+void
+WriteToStore(const tensorstore::TensorStore<> & store, const ImageIORegion & storeIORegion, const TPixel * buffer)
+{
+  const auto                      dimension = store.rank();
+  std::vector<tensorstore::Index> indices(dimension);
+  std::vector<tensorstore::Index> sizes(dimension);
+  for (size_t dim = 0; dim < dimension; ++dim)
+  {
+    indices[dim] = storeIORegion.GetIndex(dim);
+    sizes[dim] = storeIORegion.GetSize(dim);
+  }
+
+  auto arr = tensorstore::Array(buffer, sizes, tensorstore::c_order);
+  auto indexedStore = store | tensorstore::AllDims().SizedInterval(indices, sizes);
+  auto writeFuture = tensorstore::Write(tensorstore::UnownedToShared(arr), indexedStore);
+  TS_EVAL_CHECK(writeFuture);
+}
+
+// Writes to the store if the specified pixel type and the ITK component type match.
+template <typename TPixel>
+bool
+WriteToStoreIfTypesMatch(const IOComponentEnum              componentType,
+                         const tensorstore::TensorStore<> & store,
+                         const ImageIORegion &              storeIORegion,
+                         const void * const                 buffer)
+{
+  if (tensorstoreToITKComponentType(tensorstore::dtype_v<TPixel>) == componentType)
+  {
+    WriteToStore(store, storeIORegion, static_cast<TPixel const *>(buffer));
+    return true;
+  }
+  return false;
+}
+
+// Tries to write to the specified store, trying any of the specified pixel types.
+template <typename... TPixel>
+bool
+TryToWriteToStore(TypeList<TPixel...>,
+                  const IOComponentEnum              componentType,
+                  const tensorstore::TensorStore<> & store,
+                  const ImageIORegion &              storeIORegion,
+                  const void * const                 buffer)
+{
+  return (WriteToStoreIfTypesMatch<TPixel>(componentType, store, storeIORegion, buffer) || ...);
+}
+
+// Returns the kvstore specification of a resource within a store, e.g. ".zattrs" or "0".
+// An "http" kvstore, which may operate on an HTTP or HTTPS connection, is rooted at the store URL
+// with the resource as its path. All resources of a store then share one "base_url", so that
+// they are read through the same kvstore and share its connections and cache entries.
+// https://google.github.io/tensorstore/kvstore/http/index.html
+nlohmann::json
+MakeKVStoreSpec(const std::string & driver, const std::string & storePath, const std::string & resourcePath)
+{
+  if (driver == "http")
+  {
+    std::string baseURL = storePath;
+    while (!baseURL.empty() && baseURL.back() == '/')
+    {
+      baseURL.pop_back();
+    }
+    return { { "driver", driver }, { "base_url", baseURL }, { "path", resourcePath } };
+  }
+  return { { "driver", driver }, { "path", storePath + "/" + resourcePath } };
+}
+
+// JSON file path, e.g. "C:/Dev/ITKIOOMEZarrNGFF/v0.4/cyx.ome.zarr/.zgroup"
+void
+writeJson(nlohmann::json json, std::string path, std::string driver, tensorstore::Context& tsContext)
+{
+  auto attrs_store = tensorstore::Open<nlohmann::json, 0>(
+                       { { "driver", "json" }, { "kvstore", { { "driver", driver }, { "path", path } } } },
+                       tsContext,
+                       tensorstore::OpenMode::create | tensorstore::OpenMode::delete_existing,
+                       tensorstore::ReadWriteMode::read_write)
+                       .result()
+                       .value();
+  auto writeFuture = tensorstore::Write(tensorstore::MakeScalarArray(json), attrs_store); // preferably pretty-print
+
+  auto result = writeFuture.result();
+  if (!result.ok())
+  {
+    itkGenericExceptionMacro(<< "There was an error writing metadata to file '" << path
+                             << ". Error details: " << result.status());
+  }
+}
+
+// Zip stores are written into this kvstore driver, under their file name, and packed into
+// their archive by `WriteZipArchive` once the last region has been written.
+constexpr char zipStagingDriver[] = "memory";
+
+// Opens the staged entries of a zip store, keyed by their path within the archive
+tensorstore::KvStore
+OpenZipStaging(const std::string & fileName, const tensorstore::Context & tsContext)
+{
+  const nlohmann::json spec = { { "driver", zipStagingDriver }, { "path", fileName + "/" } };
+  auto                 openFuture = tensorstore::kvstore::Open(spec, tsContext);
+  TS_EVAL_CHECK(openFuture);
+  return openFuture.value();
+}
+
+// Appends a little-endian field of `bytes` bytes to a zip record
+void
+AppendZipField(std::string & record, const uint64_t value, const unsigned bytes)
+{
+  for (unsigned b = 0; b < bytes; ++b)
+  {
+    record.push_back(static_cast<char>((value >> (8 * b)) & 0xFF));
+  }
+}
+
+uint32_t
+ComputeZipCRC32(const absl::Cord & data)
+{
+  uLong crc = crc32(0L, Z_NULL, 0);
+  for (absl::string_view chunk : data.Chunks())
+  {
+    while (!chunk.empty())
+    {
+      const size_t length = std::min<size_t>(chunk.size(), 1u << 30); // zlib takes 32-bit lengths
+      crc = crc32(crc, reinterpret_cast<const Bytef *>(chunk.data()), static_cast<uInt>(length));
+      chunk.remove_prefix(length);
+    }
+  }
+  return static_cast<uint32_t>(crc);
+}
+
+// Writes the entries staged for a zip store into its archive in a single pass, removing them from staging.
+// Entries are stored uncompressed (STORE), as zarr chunks are already compressed by their codecs, in key
+// order with a fixed timestamp so that equal images give equal archives. Zip64 fields are only added where
+// sizes, offsets or counts exceed the classic zip fields. A ".memory" archive is allocated once at its final
+// size with `malloc`, and returned through the BufferInfo of the file name, whose caller frees it.
+void
+WriteZipArchive(const std::string & fileName, const tensorstore::Context & tsContext)
+{
+  const tensorstore::KvStore staging = OpenZipStaging(fileName, tsContext);
+  auto                       listFuture = tensorstore::kvstore::ListFuture(staging);
+  TS_EVAL_CHECK(listFuture);
+  std::vector<std::string> keys;
+  for (const auto & entry : listFuture.value())
+  {
+    keys.push_back(entry.key);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  // Staged values are shared rather than copied, and released as soon as they are in the archive
+  std::vector<absl::Cord> contents;
+  {
+    std::vector<tensorstore::Future<tensorstore::kvstore::ReadResult>> reads;
+    for (const auto & key : keys)
+    {
+      reads.push_back(tensorstore::kvstore::Read(staging, key));
+    }
+    for (auto & read : reads)
+    {
+      TS_EVAL_CHECK(read);
+      contents.push_back(read.value().value);
+    }
+  }
+
+  constexpr uint64_t zip32Max = 0xFFFFFFFF;
+  constexpr uint64_t zipDate = (1 << 5) | 1; // 1980-01-01, the earliest DOS date
+  std::vector<std::string> localHeaders;
+  std::string              centralDirectory;
+  uint64_t                 offset = 0;
+  for (size_t i = 0; i < keys.size(); ++i)
+  {
+    const uint64_t size = contents[i].size();
+    const uint32_t crc = ComputeZipCRC32(contents[i]);
+    const bool     sizeIsZip64 = size >= zip32Max;
+    const bool     offsetIsZip64 = offset >= zip32Max;
+    const uint64_t version = (sizeIsZip64 || offsetIsZip64) ? 45 : 20;
+    const uint64_t zip64Fields = (sizeIsZip64 ? 2 : 0) + (offsetIsZip64 ? 1 : 0);
+
+    std::string header;
+    AppendZipField(header, 0x04034b50, 4); // local file header signature
+    AppendZipField(header, version, 2);
+    AppendZipField(header, 0, 2); // flags
+    AppendZipField(header, 0, 2); // STORE
+    AppendZipField(header, 0, 2); // time
+    AppendZipField(header, zipDate, 2);
+    AppendZipField(header, crc, 4);
+    AppendZipField(header, sizeIsZip64 ? zip32Max : size, 4); // compressed size
+    AppendZipField(header, sizeIsZip64 ? zip32Max : size, 4); // uncompressed size
+    AppendZipField(header, keys[i].size(), 2);
+    AppendZipField(header, sizeIsZip64 ? 20 : 0, 2);
+    header += keys[i];
+    if (sizeIsZip64)
+    {
+      AppendZipField(header, 0x0001, 2); // zip64 extended information
+      AppendZipField(header, 16, 2);
+      AppendZipField(header, size, 8);
+      AppendZipField(header, size, 8);
+    }
+
+    AppendZipField(centralDirectory, 0x02014b50, 4); // central directory file header signature
+    AppendZipField(centralDirectory, version, 2);    // version made by
+    AppendZipField(centralDirectory, version, 2);    // version needed to extract
+    AppendZipField(centralDirectory, 0, 2);
+    AppendZipField(centralDirectory, 0, 2);
+    AppendZipField(centralDirectory, 0, 2);
+    AppendZipField(centralDirectory, zipDate, 2);
+    AppendZipField(centralDirectory, crc, 4);
+    AppendZipField(centralDirectory, sizeIsZip64 ? zip32Max : size, 4);
+    AppendZipField(centralDirectory, sizeIsZip64 ? zip32Max : size, 4);
+    AppendZipField(centralDirectory, keys[i].size(), 2);
+    AppendZipField(centralDirectory, zip64Fields > 0 ? 4 + 8 * zip64Fields : 0, 2);
+    AppendZipField(centralDirectory, 0, 2); // comment length
+    AppendZipField(centralDirectory, 0, 2); // disk number
+    AppendZipField(centralDirectory, 0, 2); // internal attributes
+    AppendZipField(centralDirectory, 0, 4); // external attributes
+    AppendZipField(centralDirectory, offsetIsZip64 ? zip32Max : offset, 4);
+    centralDirectory += keys[i];
+    if (zip64Fields > 0)
+    {
+      AppendZipField(centralDirectory, 0x0001, 2);
+      AppendZipField(centralDirectory, 8 * zip64Fields, 2);
+      if (sizeIsZip64)
+      {
+        AppendZipField(centralDirectory, size, 8);
+        AppendZipField(centralDirectory, size, 8);
+      }
+      if (offsetIsZip64)
+      {
+        AppendZipField(centralDirectory, offset, 8);
+      }
+    }
+
+    offset += header.size() + size;
+    localHeaders.push_back(std::move(header));
+  }
+
+  const uint64_t entryCount = keys.size();
+  const uint64_t centralDirectoryOffset = offset;
+  const uint64_t centralDirectorySize = centralDirectory.size();
+  std::string    end;
+  if (entryCount >= 0xFFFF || centralDirectorySize >= zip32Max || centralDirectoryOffset >= zip32Max)
+  {
+    AppendZipField(end, 0x06064b50, 4); // zip64 end of central directory record
+    AppendZipField(end, 44, 8);
+    AppendZipField(end, 45, 2);
+    AppendZipField(end, 45, 2);
+    AppendZipField(end, 0, 4);
+    AppendZipField(end, 0, 4);
+    AppendZipField(end, entryCount, 8);
+    AppendZipField(end, entryCount, 8);
+    AppendZipField(end, centralDirectorySize, 8);
+    AppendZipField(end, centralDirectoryOffset, 8);
+    AppendZipField(end, 0x07064b50, 4); // zip64 end of central directory locator
+    AppendZipField(end, 0, 4);
+    AppendZipField(end, centralDirectoryOffset + centralDirectorySize, 8);
+    AppendZipField(end, 1, 4);
+  }
+  AppendZipField(end, 0x06054b50, 4); // end of central directory record
+  AppendZipField(end, 0, 2);
+  AppendZipField(end, 0, 2);
+  AppendZipField(end, std::min<uint64_t>(entryCount, 0xFFFF), 2);
+  AppendZipField(end, std::min<uint64_t>(entryCount, 0xFFFF), 2);
+  AppendZipField(end, std::min(centralDirectorySize, zip32Max), 4);
+  AppendZipField(end, std::min(centralDirectoryOffset, zip32Max), 4);
+  AppendZipField(end, 0, 2);
+  const uint64_t archiveSize = centralDirectoryOffset + centralDirectorySize + end.size();
+
+  const bool     inMemory = fileName.size() >= 7 && fileName.substr(fileName.size() - 7) == ".memory";
+  char *         archive = nullptr;
+  std::ofstream  file;
+  uint64_t       written = 0;
+  if (inMemory)
+  {
+    archive = static_cast<char *>(std::malloc(archiveSize));
+    if (archive == nullptr)
+    {
+      itkGenericExceptionMacro("Could not allocate " << archiveSize << " bytes for the zip archive " << fileName);
+    }
+  }
+  else
+  {
+    file.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+      itkGenericExceptionMacro("Could not open " << fileName << " for writing");
+    }
+  }
+  const auto append = [&](const char * data, const size_t size) {
+    if (inMemory)
+    {
+      std::memcpy(archive + written, data, size);
+    }
+    else
+    {
+      file.write(data, size);
+    }
+    written += size;
+  };
+
+  std::vector<tensorstore::Future<tensorstore::TimestampedStorageGeneration>> deletes;
+  for (size_t i = 0; i < keys.size(); ++i)
+  {
+    append(localHeaders[i].data(), localHeaders[i].size());
+    for (const absl::string_view chunk : contents[i].Chunks())
+    {
+      append(chunk.data(), chunk.size());
+    }
+    contents[i].Clear();
+    deletes.push_back(tensorstore::kvstore::Delete(staging, keys[i]));
+  }
+  append(centralDirectory.data(), centralDirectory.size());
+  append(end.data(), end.size());
+  for (auto & deleteFuture : deletes)
+  {
+    TS_EVAL_CHECK(deleteFuture);
+  }
+  if (written != archiveSize)
+  {
+    itkGenericExceptionMacro("Wrote " << written << " bytes of the zip archive " << fileName << " instead of "
+                                      << archiveSize);
+  }
+
+  if (inMemory)
+  {
+    // The file name encodes the address of the BufferInfo, see `MakeMemoryFileName`
+    auto * bufferInfo = reinterpret_cast<OMEZarrNGFFImageIO::BufferInfo *>(std::stoull(fileName));
+    bufferInfo->pointer = archive;
+    bufferInfo->size = archiveSize;
+  }
+  else
+  {
+    file.close();
+    if (!file)
+    {
+      itkGenericExceptionMacro("Could not write the zip archive " << fileName);
+    }
+  }
+}
+
+// Store path and JSON resource within it, e.g. "C:/Dev/ITKIOOMEZarrNGFF/v0.4/cyx.ome.zarr" and ".zattrs"
+bool
+jsonRead(const std::string &    storePath,
+         const std::string &    resourcePath,
+         nlohmann::json &       result,
+         std::string            driver,
+         tensorstore::Context & tsContext)
+{
+  // Reading JSON via TensorStore allows it to be in the cloud
+  nlohmann::json readSpec = { { "driver", "json" }, { "kvstore", MakeKVStoreSpec(driver, storePath, resourcePath) } };
+
+  auto attrs_store = tensorstore::Open<nlohmann::json, 0>(readSpec, tsContext).result().value();
+
+  auto attrs_array_result = tensorstore::Read(attrs_store).result();
+
+  nlohmann::json attrs;
+  if (attrs_array_result.ok())
+  {
+    result = attrs_array_result.value()();
+    return true;
+  }
+  else if (absl::IsNotFound(attrs_array_result.status()))
+  {
+    result = nlohmann::json::object_t();
+    return false;
+  }
+  else // another error
+  {
+    result = nlohmann::json::object_t();
+    return false;
+  }
+}
+
+// Process-wide cache of metadata resources, keyed by normalized resource path.
+// Entries expire after the global metadata cache time to live, which disables the cache by default.
+std::atomic<double> metadataCacheTimeToLive{ 0.0 };
+
+// Incremented whenever cache entries are invalidated, so that instances notice that
+// the arrays they opened before may describe a store written in the meantime.
+std::atomic<uint64_t> metadataCacheGeneration{ 0 };
+
+template <typename TValue>
+class MetadataCache
+{
+public:
+  bool
+  Find(const std::string & key, TValue & value)
+  {
+    const double timeToLive = metadataCacheTimeToLive;
+    if (timeToLive == 0.0)
+    {
+      return false;
+    }
+
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    auto                              it = m_Entries.find(key);
+    if (it == m_Entries.end())
+    {
+      return false;
+    }
+    const std::chrono::duration<double> age = std::chrono::steady_clock::now() - it->second.first;
+    if (timeToLive > 0.0 && age.count() > timeToLive)
+    {
+      m_Entries.erase(it);
+      return false;
+    }
+    value = it->second.second;
+    return true;
+  }
+
+  void
+  Insert(const std::string & key, const TValue & value)
+  {
+    if (metadataCacheTimeToLive == 0.0)
+    {
+      return;
+    }
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries[key] = { std::chrono::steady_clock::now(), value };
+  }
+
+  // Removes every entry with a key starting with the given prefix.
+  void
+  Invalidate(const std::string & prefix)
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    auto                              it = m_Entries.lower_bound(prefix);
+    while (it != m_Entries.end() && it->first.compare(0, prefix.size(), prefix) == 0)
+    {
+      it = m_Entries.erase(it);
+    }
+  }
+
+  void
+  Clear()
+  {
+    const std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.clear();
+  }
+
+private:
+  std::mutex                                                                      m_Mutex;
+  std::map<std::string, std::pair<std::chrono::steady_clock::time_point, TValue>> m_Entries;
+};
+
+MetadataCache<nlohmann::json> &
+GetJsonMetadataCache()
+{
+  static MetadataCache<nlohmann::json> cache;
+  return cache;
+}
+
+MetadataCache<tensorstore::TensorStore<>> &
+GetArrayMetadataCache()
+{
+  static MetadataCache<tensorstore::TensorStore<>> cache;
+  return cache;
+}
+
+// Returns the cache key for a resource path, with duplicate and trailing separators removed.
+// In-memory zip stores are not cached because their buffers may be reused with different contents.
+std::string
+MakeMetadataCacheKey(const std::string & path)
+{
+  if (path.find(".memory") != std::string::npos)
+  {
+    return {};
+  }
+
+  const size_t schemeEnd = path.find("://");
+  const size_t start = (schemeEnd == std::string::npos) ? 0 : schemeEnd + 3;
+  std::string  key = path.substr(0, start);
+  for (size_t i = start; i < path.size(); ++i)
+  {
+    if ((path[i] == '/' || path[i] == '\\') && !key.empty() && key.back() == '/')
+    {
+      continue;
+    }
+    key += (path[i] == '\\') ? '/' : path[i];
+  }
+  while (key.size() > start && key.back() == '/')
+  {
+    key.pop_back();
+  }
+  return key;
+}
+
+// Reads JSON through the process-wide metadata cache. Missing resources are not cached.
+bool
+cachedJsonRead(const std::string &    storePath,
+               const std::string &    resourcePath,
+               nlohmann::json &       result,
+               const std::string &    driver,
+               tensorstore::Context & tsContext)
+{
+  const std::string key = MakeMetadataCacheKey(storePath + "/" + resourcePath);
+  if (!key.empty() && GetJsonMetadataCache().Find(key, result))
+  {
+    return true;
+  }
+  if (!jsonRead(storePath, resourcePath, result, driver, tsContext))
+  {
+    return false;
+  }
+  if (!key.empty())
+  {
+    GetJsonMetadataCache().Insert(key, result);
+  }
+  return true;
+}
+
+// Returns the zarr format of the existing group at the given path: 2 if it has a ".zgroup",
+// 3 if it has a "zarr.json", or 0 if it has neither. The metadata cache is bypassed, as the
+// group may have been rewritten by another writer.
+unsigned
+DetectZarrFormat(const std::string & groupPath, const std::string & driver, tensorstore::Context & tsContext)
+{
+  nlohmann::json json;
+  if (jsonRead(groupPath, ".zgroup", json, driver, tsContext))
+  {
+    return 2;
+  }
+  if (jsonRead(groupPath, "zarr.json", json, driver, tsContext))
+  {
+    return 3;
+  }
+  return 0;
+}
+
+// Removes cached metadata for every resource in the given store.
+void
+InvalidateMetadataCache(const std::string & storePath)
+{
+  const std::string key = MakeMetadataCacheKey(storePath);
+  if (!key.empty())
+  {
+    GetJsonMetadataCache().Invalidate(key);
+    GetArrayMetadataCache().Invalidate(key);
+  }
+  ++metadataCacheGeneration;
+}
+
+// Applies the coordinate transformations of multiscale metadata to the spacing and origin of an image in ITK order.
+void
+addCoordinateTransformations(const nlohmann::json & ct,
+                             std::vector<double> &  spacing,
+                             std::vector<double> &  origin,
+                             const std::string &    fileName)
+{
+  itkAssertOrThrowMacro(ct.is_array(), "Failed to parse coordinate transforms");
+  itkAssertOrThrowMacro(ct.size() >= 1, "Expected at least one coordinate transform");
+  itkAssertOrThrowMacro(ct[0].at("type") == "scale",
+                        ("Expected first transform to be \"scale\" but found " +
+                         std::string(ct[0].at("type")))); // first transformation must be scale
+
+  const nlohmann::json & s = ct[0].at("scale");
+  itkAssertOrThrowMacro(s.is_array(), "Failed to parse scale transform");
+  unsigned dim = s.size();
+  itkAssertOrThrowMacro(dim == spacing.size(), "Found dimension mismatch in scale transform");
+
+  for (unsigned d = 0; d < dim; ++d)
+  {
+    double dS = s[dim - d - 1].get<double>(); // reverse indices KJI into IJK
+    spacing[d] *= dS;
+    origin[d] *= dS; // TODO: should we update origin like this?
+  }
+
+  if (ct.size() > 1) // there is also a translation
+  {
+    itkAssertOrThrowMacro(ct[1].at("type") == "translation",
+                          ("Expected second transform to be \"translation\" but found " +
+                           std::string(ct[1].at("type")))); // first transformation must be scale
+    const nlohmann::json & tr = ct[1].at("translation");
+    itkAssertOrThrowMacro(tr.is_array(), "Failed to parse translation transform");
+    dim = tr.size();
+    itkAssertOrThrowMacro(dim == origin.size(), "Found dimension mismatch in translation transform");
+
+    for (unsigned d = 0; d < dim; ++d)
+    {
+      double dOrigin = tr[dim - d - 1].get<double>(); // reverse indices KJI into IJK
+      origin[d] += dOrigin;
+    }
+  }
+
+  if (ct.size() > 2)
+  {
+    itkGenericOutputMacro(<< "A sequence of more than 2 transformations is specified in '" << fileName
+                          << "'. This is currently not supported. Extra transformations are ignored.");
+  }
+}
+
+// Defaults for newly constructed ImageIO instances
+std::atomic<SizeValueType> globalDefaultCachePoolSize{ 0 };
+std::atomic<bool>          globalDefaultUseSharedContext{ false };
+
+// Cache pool size of chunk-aligned streaming reads and of multiscale writes when no cache pool size is set
+constexpr SizeValueType streamingCachePoolSize = 256 * 1024 * 1024;
+
+// Number of prefetches decoding at once, beyond which `Prefetch` waits for the oldest one
+constexpr size_t maximumPendingPrefetches = 16;
+
+// Number of chunks `ReadRegions` holds at once, beyond which it reads ahead no further than the region being copied
+constexpr size_t maximumRegionReadChunks = 256;
+
+// Returns a tensorstore context specification for the given resource limits.
+// Zero limits are left unspecified to use tensorstore defaults.
+nlohmann::json
+MakeContextSpec(const SizeValueType cachePoolSize, const unsigned dataCopyConcurrency, const unsigned fileIOConcurrency)
+{
+  nlohmann::json spec = nlohmann::json::object();
+  if (cachePoolSize > 0)
+  {
+    spec["cache_pool"] = { { "total_bytes_limit", cachePoolSize } };
+  }
+  if (dataCopyConcurrency > 0)
+  {
+    spec["data_copy_concurrency"] = { { "limit", dataCopyConcurrency } };
+  }
+  if (fileIOConcurrency > 0)
+  {
+    spec["file_io_concurrency"] = { { "limit", fileIOConcurrency } };
+  }
+  return spec;
+}
+
+tensorstore::Context
+MakeContext(const nlohmann::json & spec)
+{
+  auto contextSpec = tensorstore::Context::Spec::FromJson(spec);
+  if (!contextSpec.ok())
+  {
+    itkGenericExceptionMacro("tensorstore error: " << contextSpec.status());
+  }
+  return tensorstore::Context(contextSpec.value());
+}
+
+// Returns the process-wide context for the given specification,
+// which is shared by every ImageIO instance requesting the same resource limits.
+tensorstore::Context
+GetSharedContext(const nlohmann::json & spec)
+{
+  static std::mutex                                  sharedContextsMutex;
+  static std::map<std::string, tensorstore::Context> sharedContexts;
+
+  const std::lock_guard<std::mutex> lock(sharedContextsMutex);
+  const std::string                 key = spec.dump();
+  auto                              it = sharedContexts.find(key);
+  if (it == sharedContexts.end())
+  {
+    it = sharedContexts.emplace(key, MakeContext(spec)).first;
+  }
+  return it->second;
+}
+
+} // namespace
+
+struct OMEZarrNGFFImageIO::TensorStoreData
+{
+  tensorstore::Context                         tsContext{ tensorstore::Context::Default() };
+  tensorstore::TensorStore<>                   store{};
+  std::string                                  writeFileName{}; // group path created by `WriteImageInformation`, if any
+  std::vector<tensorstore::TensorStore<>>      levelStores{};   // resolution levels created by `WriteImageInformation`
+  std::vector<std::vector<tensorstore::Index>> levelDownsampleFactors{}; // factors between consecutive `levelStores`
+  tensorstore::Context                         zipStagingContext{}; // context holding the staged zip store, if any
+  nlohmann::json                               contextSpec = nlohmann::json::object(); // specification of `tsContext`
+  bool                                         contextIsShared{ false };
+  std::vector<tensorstore::Future<const void>> prefetches{}; // pending reads started by `Prefetch`
+  bool                                         warnedAboutUncachedPrefetch{ false };
+  bool                                         warnedAboutMissingMetrics{ false }; // see `CollectTensorstoreMetrics`
+  std::string                                  zarrDriver{ "zarr" }; // driver of read arrays, "zarr" or "zarr3"
+  std::array<double, 8>                        lastReadStatistics{};
+  std::array<double, 8>                        cumulativeReadStatistics{};
+  std::vector<std::string>                     datasetPaths{}; // array paths of the resolution levels read
+  std::vector<nlohmann::json>                  datasetSpecs{}; // specifications to open the arrays of the levels
+  std::vector<std::string>                     datasetCacheKeys{}; // keys of the arrays in the metadata cache, if any
+  std::string                                  multiscaleFileName{}; // group of the multiscale metadata read
+  nlohmann::json                               multiscale = nlohmann::json::object();
+  std::string                                  ngffVersion{};
+  std::string                                  attributesPath{}; // resource holding the multiscale metadata
+  bool                                         immutableStore{ false }; // whether arrays skip revalidation
+  uint64_t                                     metadataGeneration{ 0 }; // metadata cache generation when read
+  std::vector<tensorstore::Future<tensorstore::TensorStore<>>> datasetStores{}; // null until a level is opened
+  std::vector<DatasetGeometry>                                 datasetGeometries{};
+  bool           hasRawChunks{ false }; // whether the chunks of `store` are stored in `rawChunkLayout`
+  RawChunkLayout rawChunkLayout{};
+  std::string    localChunkDirectory{}; // directory of the chunk files of `store`, if local
+
+  // Forgets the multiscale metadata and the arrays read, e.g. when they may no longer describe the store
+  void
+  ClearReadState()
+  {
+    multiscaleFileName.clear();
+    multiscale = nlohmann::json::object();
+    datasetPaths.clear();
+    datasetSpecs.clear();
+    datasetCacheKeys.clear();
+    datasetStores.clear();
+    datasetGeometries.clear();
+    hasRawChunks = false;
+  }
+
+  // Starts opening the array of a resolution level, or takes it from the metadata cache
+  tensorstore::Future<tensorstore::TensorStore<>>
+  OpenDataset(size_t datasetIndex)
+  {
+    const std::string &        cacheKey = datasetCacheKeys.at(datasetIndex);
+    tensorstore::TensorStore<> cachedStore;
+    if (!cacheKey.empty() && GetArrayMetadataCache().Find(cacheKey, cachedStore))
+    {
+      return tensorstore::MakeReadyFuture(cachedStore);
+    }
+    auto openFuture = immutableStore ? tensorstore::Open(datasetSpecs.at(datasetIndex),
+                                                         tsContext,
+                                                         tensorstore::OpenMode::open,
+                                                         tensorstore::RecheckCached{ false },
+                                                         tensorstore::ReadWriteMode::read)
+                                     : tensorstore::Open(datasetSpecs.at(datasetIndex),
+                                                         tsContext,
+                                                         tensorstore::OpenMode::open,
+                                                         tensorstore::ReadWriteMode::read);
+    if (!cacheKey.empty())
+    {
+      openFuture.ExecuteWhenReady([cacheKey](tensorstore::ReadyFuture<tensorstore::TensorStore<>> opened) {
+        if (opened.result().ok())
+        {
+          GetArrayMetadataCache().Insert(cacheKey, opened.value());
+        }
+      });
+    }
+    return openFuture;
+  }
+
+  // Returns the opened array of a resolution level, opening it on first use and waiting for it to be opened
+  tensorstore::TensorStore<> &
+  DatasetStore(size_t datasetIndex)
+  {
+    auto & openFuture = datasetStores.at(datasetIndex);
+    if (openFuture.null())
+    {
+      openFuture = this->OpenDataset(datasetIndex);
+    }
+    if (!openFuture.result().ok())
+    {
+      itkGenericExceptionMacro("tensorstore error: " << openFuture.result().status());
+    }
+    return openFuture.value();
+  }
+};
+
+OMEZarrNGFFImageIO::OMEZarrNGFFImageIO()
+  : m_CachePoolSize(globalDefaultCachePoolSize)
+  , m_UseSharedContext(globalDefaultUseSharedContext)
+  , m_TensorStoreData(std::make_unique<TensorStoreData>())
+{
+  this->AddSupportedWriteExtension(".zarr");
+  this->AddSupportedWriteExtension(".zr2");
+  this->AddSupportedWriteExtension(".zr3");
+  this->AddSupportedWriteExtension(".zip");
+  this->AddSupportedWriteExtension(".memory");
+
+  this->AddSupportedReadExtension(".zarr");
+  this->AddSupportedReadExtension(".zr2");
+  this->AddSupportedReadExtension(".zr3");
+  this->AddSupportedReadExtension(".zip");
+  this->AddSupportedWriteExtension(".memory");
+
+  this->Self::SetCompressor("");
+  this->Self::SetMaximumCompressionLevel(9);
+  this->Self::SetCompressionLevel(5); // blosc default
+}
+
+OMEZarrNGFFImageIO::~OMEZarrNGFFImageIO() = default;
+
+
+void
+OMEZarrNGFFImageIO::SetGlobalDefaultCachePoolSize(SizeValueType cachePoolSize)
+{
+  globalDefaultCachePoolSize = cachePoolSize;
+}
+
+SizeValueType
+OMEZarrNGFFImageIO::GetGlobalDefaultCachePoolSize()
+{
+  return globalDefaultCachePoolSize;
+}
+
+void
+OMEZarrNGFFImageIO::SetGlobalDefaultUseSharedContext(bool useSharedContext)
+{
+  globalDefaultUseSharedContext = useSharedContext;
+}
+
+bool
+OMEZarrNGFFImageIO::GetGlobalDefaultUseSharedContext()
+{
+  return globalDefaultUseSharedContext;
+}
+
+void
+OMEZarrNGFFImageIO::SetMetadataCacheTimeToLive(double seconds)
+{
+  metadataCacheTimeToLive = seconds;
+  if (seconds == 0.0)
+  {
+    ClearMetadataCache();
+  }
+}
+
+double
+OMEZarrNGFFImageIO::GetMetadataCacheTimeToLive()
+{
+  return metadataCacheTimeToLive;
+}
+
+void
+OMEZarrNGFFImageIO::ClearMetadataCache()
+{
+  GetJsonMetadataCache().Clear();
+  GetArrayMetadataCache().Clear();
+  ++metadataCacheGeneration;
+}
+
+void
+OMEZarrNGFFImageIO::UpdateTensorStoreContext()
+{
+  // Decoding and copying stay within ITK's thread budget unless limited otherwise, so that
+  // tensorstore does not oversubscribe the cores given to ITK filters
+  const unsigned dataCopyConcurrency =
+    m_DataCopyConcurrency > 0 ? m_DataCopyConcurrency : MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+
+  // Streamed regions sharing a row of chunks find its chunks in the cache pool, as does downsampling
+  // the resolution level just written into the next one
+  const bool          needsCache = m_ChunkAlignedStreaming || m_NumberOfResolutionLevels > 1;
+  const SizeValueType cachePoolSize = (m_CachePoolSize == 0 && needsCache) ? streamingCachePoolSize : m_CachePoolSize;
+  const nlohmann::json spec = MakeContextSpec(cachePoolSize, dataCopyConcurrency, m_FileIOConcurrency);
+  if (spec != m_TensorStoreData->contextSpec || m_UseSharedContext != m_TensorStoreData->contextIsShared)
+  {
+    m_TensorStoreData->tsContext = m_UseSharedContext ? GetSharedContext(spec) : MakeContext(spec);
+    m_TensorStoreData->contextIsShared = m_UseSharedContext;
+    m_TensorStoreData->ClearReadState(); // arrays were opened with the previous context
+  }
+  m_TensorStoreData->contextSpec = spec;
+}
+
+std::string
+OMEZarrNGFFImageIO::GetTensorStoreContextSpec() const
+{
+  return m_TensorStoreData->contextSpec.dump();
+}
+
+std::string
+OMEZarrNGFFImageIO::GetGroupPath() const
+{
+  const std::string fileName = this->GetFileName();
+  return m_LabelName.empty() ? fileName : fileName + "/labels/" + m_LabelName;
+}
+
+OMEZarrNGFFImageIO::DownsamplingMethodEnum
+OMEZarrNGFFImageIO::GetLevelDownsamplingMethod() const
+{
+  // Averaging label IDs would make up IDs of other labels
+  if (!m_LabelName.empty() && m_DownsamplingMethod == DownsamplingMethodEnum::Mean)
+  {
+    return DownsamplingMethodEnum::Mode;
+  }
+  return m_DownsamplingMethod;
+}
+
+std::vector<std::string>
+OMEZarrNGFFImageIO::GetLabelNames()
+{
+  this->UpdateTensorStoreContext();
+
+  // The labels group is read through the kvstore of the store root, e.g. its "base_url" over HTTP
+  const std::string fileName = this->GetFileName();
+  const std::string driver = getKVstoreDriver(fileName);
+  nlohmann::json    json;
+  if (cachedJsonRead(fileName, "labels/.zattrs", json, driver, m_TensorStoreData->tsContext))
+  {
+    json = json.value("labels", nlohmann::json::array());
+  }
+  else if (cachedJsonRead(fileName, "labels/zarr.json", json, driver, m_TensorStoreData->tsContext))
+  {
+    json = GetZarr3OMEAttributes(json).value("labels", nlohmann::json::array());
+  }
+  else
+  {
+    return {}; // the image has no labels group
+  }
+
+  std::vector<std::string> labelNames;
+  for (const auto & labelName : json)
+  {
+    labelNames.push_back(labelName.get<std::string>());
+  }
+  return labelNames;
+}
+
+void
+OMEZarrNGFFImageIO::InternalSetCompressor(const std::string & _compressor)
+{
+  if (!_compressor.empty() &&
+      std::find(supportedCompressors.begin(), supportedCompressors.end(), _compressor) == supportedCompressors.end())
+  {
+    this->Superclass::InternalSetCompressor(_compressor); // warns and resets to default
+  }
+}
+
+
+void
+OMEZarrNGFFImageIO::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "LabelName: " << m_LabelName << std::endl;
+  os << indent << "DatasetIndex: " << m_DatasetIndex << std::endl;
+  os << indent << "TimeIndex: " << m_TimeIndex << std::endl;
+  os << indent << "ChannelIndex: " << m_ChannelIndex << std::endl;
+  os << indent << "ChannelsAsComponents: " << (m_ChannelsAsComponents ? "On" : "Off") << std::endl;
+  os << indent << "ChannelIndices: [";
+  for (const auto channelIndex : m_ChannelIndices)
+  {
+    os << ' ' << channelIndex;
+  }
+  os << " ]" << std::endl;
+  os << indent << "TimeAsDimension: " << (m_TimeAsDimension ? "On" : "Off") << std::endl;
+  os << indent << "NumberOfTimePoints: " << m_NumberOfTimePoints << std::endl;
+  os << indent << "ChunkAlignedStreaming: " << (m_ChunkAlignedStreaming ? "On" : "Off") << std::endl;
+  os << indent << "ReadAheadDepth: " << m_ReadAheadDepth << std::endl;
+  os << indent << "DirectChunkReading: " << (m_DirectChunkReading ? "On" : "Off") << std::endl;
+  os << indent << "MemoryMappedReading: " << (m_MemoryMappedReading ? "On" : "Off") << std::endl;
+  os << indent << "CollectReadStatistics: " << (m_CollectReadStatistics ? "On" : "Off") << std::endl;
+  os << indent << "ReadStatisticsInMetaDataDictionary: " << (m_ReadStatisticsInMetaDataDictionary ? "On" : "Off")
+     << std::endl;
+  os << indent << "ChunkShape: [";
+  for (const auto chunkSize : m_ChunkShape)
+  {
+    os << ' ' << chunkSize;
+  }
+  os << " ]" << std::endl;
+  os << indent << "ZarrFormat: " << m_ZarrFormat << std::endl;
+  os << indent << "ShardShape: [";
+  for (const auto shardSize : m_ShardShape)
+  {
+    os << ' ' << shardSize;
+  }
+  os << " ]" << std::endl;
+  os << indent << "TargetChunkSizeInBytes: " << m_TargetChunkSizeInBytes << std::endl;
+  os << indent << "NumberOfResolutionLevels: " << m_NumberOfResolutionLevels << std::endl;
+  os << indent << "DownsamplingMethod: " << m_DownsamplingMethod << std::endl;
+  os << indent << "WriteMode: " << m_WriteMode << std::endl;
+  os << indent << "CachePoolSize: " << m_CachePoolSize << std::endl;
+  os << indent << "DataCopyConcurrency: " << m_DataCopyConcurrency << std::endl;
+  os << indent << "FileIOConcurrency: " << m_FileIOConcurrency << std::endl;
+  os << indent << "UseSharedContext: " << (m_UseSharedContext ? "On" : "Off") << std::endl;
+  os << indent << "ImmutableStore: " << (m_ImmutableStore ? "On" : "Off") << std::endl;
+}
+
+bool
+OMEZarrNGFFImageIO::CanReadFile(const char * filename)
+{
+  try
+  {
+    this->UpdateTensorStoreContext();
+    std::string    driver = getKVstoreDriver(filename);
+    nlohmann::json json;
+    if (!cachedJsonRead(filename, ".zgroup", json, driver, m_TensorStoreData->tsContext))
+    {
+      // zarr v3 groups keep their attributes in "zarr.json"
+      if (!cachedJsonRead(filename, "zarr.json", json, driver, m_TensorStoreData->tsContext))
+      {
+        return false;
+      }
+      return json.at("zarr_format").get<int>() == 3 && json.at("node_type").get<std::string>() == "group" &&
+             GetZarr3OMEAttributes(json).at("multiscales").is_array();
+    }
+    if (json.at("zarr_format").get<int>() != 2)
+    {
+      return false; // unsupported zarr format
+    }
+    if (!cachedJsonRead(filename, ".zattrs", json, driver, m_TensorStoreData->tsContext))
+    {
+      return false;
+    }
+    if (!json.at("multiscales").is_array())
+    {
+      return false; // multiscales attribute array must be present
+    }
+    return true;
+  }
+  catch (...)
+  {
+    return false;
+  }
+  // return this->HasSupportedWriteExtension(filename, true);
+}
+
+void
+OMEZarrNGFFImageIO::ReadArrayMetadata(unsigned datasetIndex)
+{
+  m_TensorStoreData->writeFileName.clear();
+  m_TensorStoreData->levelStores.clear();
+  m_TensorStoreData->levelDownsampleFactors.clear();
+  auto shape_span = m_TensorStoreData->store.domain().shape();
+
+  tensorstore::DataType dtype = m_TensorStoreData->store.dtype();
+  this->SetComponentType(tensorstoreToITKComponentType(dtype));
+
+  std::vector<SizeValueType> dimensions;
+  std::vector<double>        spacing;
+  std::vector<double>        origin;
+  this->ComputeDatasetGeometry(
+    datasetIndex, std::vector<int64_t>(shape_span.begin(), shape_span.end()), dimensions, spacing, origin);
+  this->InitializeIdentityMetadata(dimensions.size());
+  for (unsigned d = 0; d < dimensions.size(); ++d)
+  {
+    this->SetDimensions(d, dimensions[d]);
+    this->SetSpacing(d, spacing[d]);
+    this->SetOrigin(d, origin[d]);
+  }
+
+  // Optionally read the channel axis into pixel components rather than an ITK axis
+  const auto channelAxis = std::find_if(m_StoreAxes.cbegin(), m_StoreAxes.cend(), [](const OMEZarrNGFFAxis & axis) {
+    return axis.name == "c";
+  });
+  if (m_ChannelsAsComponents && channelAxis != m_StoreAxes.cend())
+  {
+    const SizeValueType numberOfChannels = shape_span[m_StoreAxes.cend() - channelAxis - 1]; // convert IJK into KJI
+    this->SetNumberOfComponents(m_ChannelIndices.empty() ? numberOfChannels : m_ChannelIndices.size());
+    this->SetPixelType(this->GetNumberOfComponents() > 1 ? IOPixelEnum::VECTOR : IOPixelEnum::SCALAR);
+  }
+  else
+  {
+    this->SetNumberOfComponents(1);
+    this->SetPixelType(IOPixelEnum::SCALAR);
+  }
+}
+
+void
+OMEZarrNGFFImageIO::ComputeDatasetGeometry(unsigned                     datasetIndex,
+                                           const std::vector<int64_t> & storeShape,
+                                           std::vector<SizeValueType> & dimensions,
+                                           std::vector<double> &        spacing,
+                                           std::vector<double> &        origin) const
+{
+  const nlohmann::json & json = m_TensorStoreData->multiscale;
+  const std::string &    version = m_TensorStoreData->ngffVersion;
+  const bool             requiresTransformations = (version == "0.4" || version == "0.5");
+
+  // Names of the axes in ITK order, which are optional before 0.3
+  std::vector<std::string> axisNames;
+  if (json.contains("axes"))
+  {
+    for (const auto & axis : json.at("axes"))
+    {
+      axisNames.insert(axisNames.begin(), axis.at("name").get<std::string>());
+    }
+  }
+  else if (requiresTransformations)
+  {
+    itkExceptionMacro(<< "\"axes\" field is missing from OME-Zarr image metadata at "
+                      << m_TensorStoreData->attributesPath);
+  }
+  spacing.assign(axisNames.size(), 1.0);
+  origin.assign(axisNames.size(), 0.0);
+
+  if (json.contains("coordinateTransformations")) // optional
+  {
+    // dataset-level scaling
+    addCoordinateTransformations(json.at("coordinateTransformations"), spacing, origin, this->GetFileName());
+  }
+
+  const nlohmann::json & dataset = json.at("datasets")[datasetIndex];
+  if (dataset.contains("coordinateTransformations")) // optional for versions prior to 0.4
+  {
+    // per-resolution scaling
+    addCoordinateTransformations(dataset.at("coordinateTransformations"), spacing, origin, this->GetFileName());
+  }
+  else if (requiresTransformations)
+  {
+    itkExceptionMacro(<< "OME-NGFF v" << version << " requires `coordinateTransformations` for each resolution level.");
+  }
+
+  dimensions.assign(storeShape.rbegin(), storeShape.rend()); // convert KJI into IJK
+  if (axisNames.empty()) // reading version 0.2 or 0.1
+  {
+    spacing.assign(dimensions.size(), 1.0);
+    origin.assign(dimensions.size(), 0.0);
+  }
+  else
+  {
+    itkAssertOrThrowMacro(axisNames.size() == dimensions.size(), "Found dimension mismatch in metadata");
+  }
+
+  // Optionally read the time axis as an ITK dimension, starting at the requested time point
+  const auto timeAxis = std::find(axisNames.cbegin(), axisNames.cend(), "t");
+  if (m_TimeAsDimension && timeAxis != axisNames.cend())
+  {
+    const unsigned      timeDimension = std::distance(axisNames.cbegin(), timeAxis);
+    const SizeValueType numberOfTimePoints = dimensions[timeDimension];
+    const SizeValueType firstTimePoint = std::max(m_TimeIndex, 0);
+    if (m_TimeIndex < INVALID_INDEX ||
+        firstTimePoint + std::max<SizeValueType>(m_NumberOfTimePoints, 1) > numberOfTimePoints)
+    {
+      itkExceptionMacro(<< "Requested " << m_NumberOfTimePoints << " time points from time index " << m_TimeIndex
+                        << " are out of range for the " << numberOfTimePoints << " time points in OME-NGFF store '"
+                        << this->GetFileName() << "'");
+    }
+    dimensions[timeDimension] = m_NumberOfTimePoints == 0 ? numberOfTimePoints - firstTimePoint : m_NumberOfTimePoints;
+    origin[timeDimension] += firstTimePoint * spacing[timeDimension];
+  }
+
+  // The channel axis is sliced at ChannelIndex when reading time as a dimension, or read into pixel components
+  const auto channelAxis = std::find(axisNames.cbegin(), axisNames.cend(), "c");
+  if ((m_TimeAsDimension || m_ChannelsAsComponents) && channelAxis != axisNames.cend())
+  {
+    const auto channelDimension = std::distance(axisNames.cbegin(), channelAxis);
+    if (m_ChannelsAsComponents)
+    {
+      const SizeValueType numberOfChannels = dimensions[channelDimension];
+      for (const auto channelIndex : m_ChannelIndices)
+      {
+        if (channelIndex < 0 || static_cast<SizeValueType>(channelIndex) >= numberOfChannels)
+        {
+          itkExceptionMacro(<< "Requested channel index " << channelIndex << " is out of range for the "
+                            << numberOfChannels << " channels in OME-NGFF store '" << this->GetFileName() << "'");
+        }
+      }
+    }
+    dimensions.erase(dimensions.begin() + channelDimension);
+    spacing.erase(spacing.begin() + channelDimension);
+    origin.erase(origin.begin() + channelDimension);
+  }
+}
+
+void
+OMEZarrNGFFImageIO::RemoveDimension(unsigned axis)
+{
+  const unsigned             nDims = this->GetNumberOfDimensions();
+  std::vector<SizeValueType> dims;
+  std::vector<double>        spacing;
+  std::vector<double>        origin;
+  for (unsigned d = 0; d < nDims; ++d)
+  {
+    if (d != axis)
+    {
+      dims.push_back(this->GetDimensions(d));
+      spacing.push_back(this->GetSpacing(d));
+      origin.push_back(this->GetOrigin(d));
+    }
+  }
+
+  this->InitializeIdentityMetadata(nDims - 1);
+  for (unsigned d = 0; d < nDims - 1; ++d)
+  {
+    this->SetDimensions(d, dims[d]);
+    this->SetSpacing(d, spacing[d]);
+    this->SetOrigin(d, origin[d]);
+  }
+}
+
+ImageIORegion
+OMEZarrNGFFImageIO::ConfigureTensorstoreIORegion(const ImageIORegion & ioRegion) const
+{
+  return this->ConfigureTensorstoreIORegion(ioRegion, m_TimeIndex, m_ChannelIndex);
+}
+
+ImageIORegion
+OMEZarrNGFFImageIO::ConfigureTensorstoreIORegion(const ImageIORegion & ioRegion, int timeIndex, int channelIndex) const
+{
+  const auto storeRank = m_TensorStoreData->store.rank();
+
+  // Set up IO region to match known store dimensions
+  itkAssertOrThrowMacro(m_StoreAxes.size() == storeRank, "Detected mismatch in axis count and store rank");
+  ImageIORegion storeRegion(storeRank);
+  itkAssertOrThrowMacro(storeRegion.GetImageDimension(), storeRank);
+  auto storeAxes = this->GetAxesInStoreOrder();
+
+  // In TimeAsDimension mode the time axis follows the spatial axes
+  const auto timeITKAxis = std::count_if(storeAxes.cbegin(), storeAxes.cend(), [](const OMEZarrNGFFAxis & axis) {
+    return GetSpatialITKAxis(axis.name) >= 0;
+  });
+
+  for (size_t storeIndex = 0; storeIndex < storeRank; ++storeIndex)
+  {
+    auto axisName = storeAxes.at(storeIndex).name;
+
+    if (axisName == "t" && m_TimeAsDimension)
+    {
+      itkAssertOrThrowMacro(ioRegion.GetImageDimension() > static_cast<unsigned>(timeITKAxis),
+                            "Failed to read from \"t\" axis into an ITK axis");
+      const IndexValueType firstTimePoint = std::max(timeIndex, 0);
+      storeRegion.SetSize(storeIndex, ioRegion.GetSize(timeITKAxis));
+      storeRegion.SetIndex(storeIndex, firstTimePoint + ioRegion.GetIndex(timeITKAxis));
+    }
+    // Optionally slice time or channel indices
+    else if (axisName == "t")
+    {
+      storeRegion.SetSize(storeIndex, 1);
+      if (timeIndex == INVALID_INDEX)
+      {
+        itkWarningMacro(<< "The OME-Zarr store contains a time \"t\" axis but no time point has been specified. "
+                           "Reading along a time axis is not currently supported. Data will be read from the first "
+                           "available time point by default.");
+        storeRegion.SetIndex(storeIndex, 0);
+      }
+      else
+      {
+        storeRegion.SetIndex(storeIndex, timeIndex);
+      }
+    }
+    else if (axisName == "c" && m_ChannelsAsComponents)
+    {
+      // Read the selected channels into pixel components. A contiguous run of channels
+      // is read as an interval, while other selections are applied when reading.
+      if (!m_ChannelIndices.empty() && IsContiguousRun(m_ChannelIndices))
+      {
+        storeRegion.SetIndex(storeIndex, m_ChannelIndices.front());
+        storeRegion.SetSize(storeIndex, m_ChannelIndices.size());
+      }
+      else
+      {
+        storeRegion.SetIndex(storeIndex, 0);
+        storeRegion.SetSize(storeIndex, m_TensorStoreData->store.domain().shape()[storeIndex]);
+      }
+    }
+    else if (axisName == "c")
+    {
+      storeRegion.SetSize(storeIndex, 1);
+      if (channelIndex == INVALID_INDEX)
+      {
+        itkWarningMacro(<< "The OME-Zarr store contains a channel \"c\" axis but no channel index has been specified. "
+                           "Reading along a channel axis is not currently supported. Data will be read from the first "
+                           "available channel by default.");
+        storeRegion.SetIndex(storeIndex, 0);
+      }
+      else
+      {
+        storeRegion.SetIndex(storeIndex, channelIndex);
+      }
+    }
+    // Set requested region on X/Y/Z axes
+    else if (axisName == "x")
+    {
+      itkAssertOrThrowMacro(ioRegion.GetImageDimension() >= 1, "Failed to read from \"x\" axis into ITK axis \"0\"");
+      storeRegion.SetSize(storeIndex, ioRegion.GetSize(0));
+      storeRegion.SetIndex(storeIndex, ioRegion.GetIndex(0));
+    }
+    else if (axisName == "y")
+    {
+      itkAssertOrThrowMacro(ioRegion.GetImageDimension() >= 2, "Failed to read from \"y\" axis into ITK axis \"1\"");
+      storeRegion.SetSize(storeIndex, ioRegion.GetSize(1));
+      storeRegion.SetIndex(storeIndex, ioRegion.GetIndex(1));
+    }
+    else if (axisName == "z")
+    {
+      itkAssertOrThrowMacro(ioRegion.GetImageDimension() >= 3, "Failed to read from \"z\" axis into ITK axis \"2\"");
+      storeRegion.SetSize(storeIndex, ioRegion.GetSize(2));
+      storeRegion.SetIndex(storeIndex, ioRegion.GetIndex(2));
+    }
+  }
+
+  return storeRegion;
+}
+
+void
+OMEZarrNGFFImageIO::ReadImageInformation()
+{
+  this->UpdateTensorStoreContext();
+
+  // Switching between levels of the same store neither reads its multiscale metadata nor opens an array again,
+  // unless the store may have changed since, see `ReadMultiscaleMetadata`
+  this->ReadMultiscaleMetadata();
+
+  const auto numberOfDatasets = static_cast<int>(m_TensorStoreData->datasetPaths.size());
+  if (this->GetDatasetIndex() < 0 || this->GetDatasetIndex() >= numberOfDatasets)
   {
-    this->SetDimensions(d, dims[d]);
+    itkExceptionMacro(<< "Requested DatasetIndex of " << this->GetDatasetIndex()
+                      << " is out of range for the number of datasets (" << numberOfDatasets
+                      << ") which exist in OME-NGFF store '" << this->GetFileName() << "'");
+  }
+
+  // Only the array of the requested level is opened here. The image information of the other levels is
+  // determined on request, and kept while the multiscale metadata and the time and channel settings are unchanged.
+  if (m_TensorStoreData->datasetGeometries.size() != static_cast<size_t>(numberOfDatasets))
+  {
+    m_TensorStoreData->datasetGeometries.assign(numberOfDatasets, DatasetGeometry{});
   }
+  this->ReadDatasetMetadata(this->GetDatasetIndex());
+  m_TensorStoreData->datasetGeometries[this->GetDatasetIndex()] = MakeDatasetGeometry(*this);
 }
 
-ImageIORegion
-OMEZarrNGFFImageIO::ConfigureTensorstoreIORegion(const ImageIORegion & ioRegion) const
+void
+OMEZarrNGFFImageIO::ReadMultiscaleMetadata()
+{
+  nlohmann::json    json;
+  const std::string fileName = this->GetFileName();
+  std::string       driver = getKVstoreDriver(fileName);
+  const std::string groupPath = this->GetGroupPath();
+  const std::string previousZarrDriver = m_TensorStoreData->zarrDriver;
+  const uint64_t    metadataGeneration = metadataCacheGeneration;
+
+  // The group parsed before is not read again unless this process has written it or invalidated the metadata
+  // cache since, e.g. through ClearMetadataCache. With ImmutableStore on, the group is assumed not to change.
+  if (m_TensorStoreData->multiscaleFileName == groupPath && m_TensorStoreData->immutableStore == m_ImmutableStore &&
+      (m_ImmutableStore || m_TensorStoreData->metadataGeneration == metadataGeneration))
+  {
+    return;
+  }
+
+  // Resources of label images are read through the kvstore of the store root, e.g. its "base_url" over HTTP
+  const std::string groupPrefix = m_LabelName.empty() ? std::string() : "labels/" + m_LabelName + "/";
+
+  const std::string zgroupFilePath(groupPath + "/.zgroup");
+  const std::string zarrJsonFilePath(groupPath + "/zarr.json");
+  std::string       zattrsFilePath; // file holding the OME-NGFF attributes
+  std::string       version;
+  if (cachedJsonRead(fileName, groupPrefix + ".zgroup", json, driver, m_TensorStoreData->tsContext))
+  {
+    itkAssertOrThrowMacro(json.at("zarr_format").get<int>() == 2, ("Expected zarr format 2 in " + zgroupFilePath));
+    m_TensorStoreData->zarrDriver = "zarr";
+
+    zattrsFilePath = groupPath + "/.zattrs";
+    const bool status = cachedJsonRead(fileName, groupPrefix + ".zattrs", json, driver, m_TensorStoreData->tsContext);
+    itkAssertOrThrowMacro(status, ("Failed to read from " + zattrsFilePath));
+    json = json.at("multiscales")[0]; // multiscales must be present in OME-NGFF
+    version = json.at("version").get<std::string>();
+  }
+  else
+  {
+    const bool status =
+      cachedJsonRead(fileName, groupPrefix + "zarr.json", json, driver, m_TensorStoreData->tsContext);
+    itkAssertOrThrowMacro(status, ("Failed to read from " + zgroupFilePath + " or " + zarrJsonFilePath));
+    itkAssertOrThrowMacro(json.at("zarr_format").get<int>() == 3, "Only zarr formats 2 and 3 are supported");
+    m_TensorStoreData->zarrDriver = "zarr3";
+
+    // OME-NGFF 0.5 keeps its version next to the multiscales, rather than in each multiscale
+    zattrsFilePath = zarrJsonFilePath;
+    const nlohmann::json omeAttributes = GetZarr3OMEAttributes(json);
+    json = omeAttributes.at("multiscales")[0];
+    version = (omeAttributes.contains("version") ? omeAttributes : json).at("version").get<std::string>();
+  }
+  if (version == "0.5" || version == "0.4" || version == "0.3" || version == "0.2" || version == "0.1")
+  {
+    // these are explicitly supported versions
+  }
+  else
+  {
+    std::string message = "OME-NGFF version " + version + " is not explicitly supported." +
+                          "\nImportant features might be ignored." + "\nSupported versions are 0.1 through 0.5.";
+    OutputWindowDisplayWarningText(message.c_str());
+  }
+
+  // Keep the arrays opened for the same metadata, unless they were opened with another revalidation
+  // setting or this process has written the store since
+  if (m_TensorStoreData->multiscaleFileName == groupPath && m_TensorStoreData->multiscale == json &&
+      m_TensorStoreData->zarrDriver == previousZarrDriver && m_TensorStoreData->immutableStore == m_ImmutableStore &&
+      m_TensorStoreData->metadataGeneration == metadataGeneration)
+  {
+    return;
+  }
+  m_TensorStoreData->ClearReadState();
+  m_TensorStoreData->multiscale = json;
+  m_TensorStoreData->ngffVersion = version;
+  m_TensorStoreData->attributesPath = zattrsFilePath;
+  m_TensorStoreData->immutableStore = m_ImmutableStore;
+  m_TensorStoreData->metadataGeneration = metadataGeneration;
+
+  // Arrays are opened on first use, see `TensorStoreData::DatasetStore`
+  for (const auto & dataset : json.at("datasets"))
+  {
+    const std::string arrayPath = dataset.at("path").get<std::string>();
+    m_TensorStoreData->datasetPaths.push_back(arrayPath);
+    m_TensorStoreData->datasetSpecs.push_back(
+      { { "driver", m_TensorStoreData->zarrDriver },
+        { "kvstore", MakeKVStoreSpec(driver, fileName, groupPrefix + arrayPath) } });
+
+    // Opened arrays hold the context they were opened with, so they are only cached for shared contexts,
+    // keyed by the context specification and by how the opened array revalidates its cache
+    std::string cacheKey;
+    if (m_TensorStoreData->contextIsShared)
+    {
+      cacheKey = MakeMetadataCacheKey(groupPath + "/" + arrayPath);
+      if (!cacheKey.empty())
+      {
+        cacheKey += "\n" + m_TensorStoreData->contextSpec.dump() + (m_ImmutableStore ? " immutable" : "");
+      }
+    }
+    m_TensorStoreData->datasetCacheKeys.push_back(cacheKey);
+  }
+  m_TensorStoreData->datasetStores.resize(m_TensorStoreData->datasetPaths.size());
+  m_TensorStoreData->multiscaleFileName = groupPath;
+}
+
+void
+OMEZarrNGFFImageIO::RecordDatasetGeometry(unsigned datasetIndex) const
+{
+  if (m_TensorStoreData->multiscaleFileName != this->GetGroupPath())
+  {
+    itkExceptionMacro(<< "Requested DatasetIndex of " << datasetIndex
+                      << " is out of range, as the image information of '" << this->GetFileName() << "' was not read");
+  }
+  auto & geometries = m_TensorStoreData->datasetGeometries;
+  if (datasetIndex >= geometries.size() || IsGeometryRecorded(geometries[datasetIndex], *this))
+  {
+    return;
+  }
+
+  // The geometry is computed from the shape of the array of the level, which is opened here if not open yet,
+  // without modifying the image information read
+  DatasetGeometry geometry;
+  try
+  {
+    const auto shape = m_TensorStoreData->DatasetStore(datasetIndex).domain().shape();
+    this->ComputeDatasetGeometry(datasetIndex,
+                                 std::vector<int64_t>(shape.begin(), shape.end()),
+                                 geometry.dimensions,
+                                 geometry.spacing,
+                                 geometry.origin);
+  }
+  catch (const ExceptionObject & error)
+  {
+    geometry = DatasetGeometry{};
+    geometry.error = error.GetDescription();
+  }
+  geometry.recorded = true;
+  geometry.settings = MakeGeometrySettings(*this);
+  geometries[datasetIndex] = geometry;
+}
+
+void
+OMEZarrNGFFImageIO::ReadDatasetMetadata(unsigned datasetIndex)
+{
+  const nlohmann::json & json = m_TensorStoreData->multiscale;
+  if (json.contains("axes")) // optional before 0.3
+  {
+    m_StoreAxes.resize(json.at("axes").size());
+    auto targetIt = m_StoreAxes.rbegin();
+    for (const auto & axis : json.at("axes"))
+    {
+      *targetIt = (OMEZarrNGFFAxis{ axis.at("name"), axis.at("type"), (axis.contains("unit") ? axis.at("unit") : "") });
+      ++targetIt;
+    }
+    itkAssertOrThrowMacro(targetIt == m_StoreAxes.rend(),
+                          "Internal error: failed to fully parse axes from OME-Zarr metadata");
+  }
+
+  // TODO: parse stuff from "metadata" object into metadata dictionary
+
+  m_TensorStoreData->store = m_TensorStoreData->DatasetStore(datasetIndex);
+  this->ReadArrayMetadata(datasetIndex);
+
+  // The raw chunk layout is determined once per opened array rather than on each read
+  m_TensorStoreData->hasRawChunks = GetRawChunkLayout(m_TensorStoreData->store, m_TensorStoreData->rawChunkLayout);
+  m_TensorStoreData->localChunkDirectory =
+    m_TensorStoreData->hasRawChunks ? GetLocalChunkDirectory(m_TensorStoreData->store) : std::string();
+}
+
+void
+OMEZarrNGFFImageIO::Read(void * buffer)
+{
+  const ComponentAxis componentAxis =
+    FindComponentAxis(this->GetAxesInStoreOrder(), m_ChannelsAsComponents, m_ChannelIndices);
+
+  // Use a proxy measure (voxel count) to determine whether we are reading
+  // the entire image or an image subregion.
+  // This comparison needs to be done carefully, we can compare 3D and 6D regions
+  if (componentAxis.storeIndex < 0 && !m_TimeAsDimension &&
+      this->GetLargestRegion().GetNumberOfPixels() == m_IORegion.GetNumberOfPixels())
+  {
+    itkAssertOrThrowMacro(m_TensorStoreData->store.domain().num_elements() == m_IORegion.GetNumberOfPixels(),
+                          "Detected mismatch between store size and size of largest possible region");
+  }
+  else if (componentAxis.storeIndex < 0 && !m_TimeAsDimension)
+  {
+    // Get a requested image subregion
+    itkAssertOrThrowMacro(this->GetNumberOfComponents() == 1,
+                          "Reading an image subregion is currently supported only for single channel images");
+  }
+  auto storeIORegion = this->ConfigureTensorstoreIORegion(m_IORegion);
+
+  if (this->GetDebug())
+  {
+    std::cout << "Preparing to read " << storeIORegion.GetNumberOfPixels() << " elements from tensorstore region "
+              << storeIORegion;
+  }
+
+  TensorstoreMetrics metricsBeforeRead;
+  const auto         readStart = std::chrono::steady_clock::now();
+  if (m_CollectReadStatistics)
+  {
+    metricsBeforeRead = CollectTensorstoreMetrics();
+  }
+
+  // Chunks stored raw in the buffer layout are copied directly, unless the chunk cache is used to read ahead.
+  // Chunks copied from memory mapped files are read ahead into the page cache instead.
+  const RawChunkLayout & rawChunkLayout = m_TensorStoreData->rawChunkLayout;
+  RawChunkReadInfo       rawChunkReadInfo;
+  const bool hasRawChunks = m_DirectChunkReading && componentAxis.storeIndex < 0 && m_TensorStoreData->hasRawChunks;
+  const std::string mappedChunkDirectory =
+    (hasRawChunks && m_MemoryMappedReading) ? m_TensorStoreData->localChunkDirectory : std::string();
+  bool              readMappedChunks = false;
+  if (hasRawChunks && (m_ReadAheadDepth == 0 || !mappedChunkDirectory.empty()) &&
+      ReadRawChunks(
+        m_TensorStoreData->store, rawChunkLayout, storeIORegion, buffer, rawChunkReadInfo, mappedChunkDirectory))
+  {
+    readMappedChunks = !mappedChunkDirectory.empty();
+    if (this->GetDebug())
+    {
+      std::cout << "Copied raw chunks of tensorstore region " << storeIORegion
+                << (readMappedChunks ? " from memory mapped files" : "");
+    }
+  }
+  else if (const IOComponentEnum componentType{ this->GetComponentType() };
+           !TryToReadFromStore(
+             supportedPixelTypes, componentType, m_TensorStoreData->store, storeIORegion, componentAxis, buffer))
+  {
+    itkExceptionMacro("Unsupported component type: " << GetComponentTypeAsString(componentType));
+  }
+
+  if (m_CollectReadStatistics)
+  {
+    const auto metricsAfterRead = CollectTensorstoreMetrics();
+    const auto kvstoreReads = MetricDelta(metricsBeforeRead.kvstoreReads, metricsAfterRead.kvstoreReads);
+    const auto kvstoreBytesRead = MetricDelta(metricsBeforeRead.kvstoreBytesRead, metricsAfterRead.kvstoreBytesRead);
+    const auto kvstoreReadMilliseconds =
+      MetricDelta(metricsBeforeRead.kvstoreReadMilliseconds, metricsAfterRead.kvstoreReadMilliseconds);
+    const auto httpRequests = MetricDelta(metricsBeforeRead.httpRequests, metricsAfterRead.httpRequests);
+    if (!(kvstoreReads && kvstoreBytesRead && kvstoreReadMilliseconds && httpRequests) &&
+        !m_TensorStoreData->warnedAboutMissingMetrics)
+    {
+      itkWarningMacro(<< "Some tensorstore metrics are not available, so the read statistics derived from them "
+                         "are reported as 0, and every requested chunk is counted as fetched and decoded.");
+      m_TensorStoreData->warnedAboutMissingMetrics = true;
+    }
+
+    auto &       statistics = m_TensorStoreData->lastReadStatistics;
+    const double chunkBytes = static_cast<double>(m_TensorStoreData->store.dtype().size()) *
+                              [](const std::vector<tensorstore::Index> & chunkShape) {
+                                double elements = 1.0;
+                                for (const auto chunkSize : chunkShape)
+                                {
+                                  elements *= chunkSize;
+                                }
+                                return elements;
+                              }(GetChunkShape(m_TensorStoreData->store));
+    statistics.fill(0.0);
+    if (rawChunkReadInfo.chunks > 0)
+    {
+      statistics[static_cast<size_t>(ReadStatisticEnum::ChunksRequested)] = rawChunkReadInfo.chunks;
+      statistics[static_cast<size_t>(ReadStatisticEnum::BytesDecoded)] = rawChunkReadInfo.bytes;
+      statistics[static_cast<size_t>(ReadStatisticEnum::CopySeconds)] = rawChunkReadInfo.copySeconds;
+    }
+    else
+    {
+      // Estimates: chunks which were not read from the kvstore were served from the chunk cache, and each
+      // kvstore read fetched and decoded one chunk
+      const double chunksRequested = CountChunks(m_TensorStoreData->store, storeIORegion);
+      const double chunksFetched = std::min(chunksRequested, kvstoreReads.value_or(chunksRequested));
+      statistics[static_cast<size_t>(ReadStatisticEnum::ChunksRequested)] = chunksRequested;
+      statistics[static_cast<size_t>(ReadStatisticEnum::ChunksFromCache)] = chunksRequested - chunksFetched;
+      statistics[static_cast<size_t>(ReadStatisticEnum::BytesDecoded)] = chunksFetched * chunkBytes;
+    }
+    statistics[static_cast<size_t>(ReadStatisticEnum::BytesFetched)] = kvstoreBytesRead.value_or(0.0);
+    statistics[static_cast<size_t>(ReadStatisticEnum::HTTPRequests)] = httpRequests.value_or(0.0);
+    statistics[static_cast<size_t>(ReadStatisticEnum::KVStoreSeconds)] = kvstoreReadMilliseconds.value_or(0.0) / 1000.0;
+    statistics[static_cast<size_t>(ReadStatisticEnum::TotalSeconds)] =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - readStart).count();
+
+    for (size_t statistic = 0; statistic < statistics.size(); ++statistic)
+    {
+      m_TensorStoreData->cumulativeReadStatistics[statistic] += statistics[statistic];
+    }
+    if (m_ReadStatisticsInMetaDataDictionary)
+    {
+      MetaDataDictionary & dictionary = this->GetMetaDataDictionary();
+      for (size_t statistic = 0; statistic < statistics.size(); ++statistic)
+      {
+        EncapsulateMetaData<double>(
+          dictionary, "OMEZarrNGFF_LastRead_" + readStatisticNames[statistic], statistics[statistic]);
+        EncapsulateMetaData<double>(dictionary,
+                                    "OMEZarrNGFF_Cumulative_" + readStatisticNames[statistic],
+                                    m_TensorStoreData->cumulativeReadStatistics[statistic]);
+      }
+    }
+  }
+
+  // Read ahead along the slowest varying axis which is split into regions
+  if (m_ReadAheadDepth > 0)
+  {
+    for (int axis = m_IORegion.GetImageDimension() - 1; axis >= 0; --axis)
+    {
+      const auto extent = static_cast<IndexValueType>(this->GetDimensions(axis));
+      const auto size = static_cast<IndexValueType>(m_IORegion.GetSize(axis));
+      if (size == extent)
+      {
+        continue;
+      }
+
+      ImageIORegion nextRegion(m_IORegion);
+      for (unsigned depth = 1; depth <= m_ReadAheadDepth; ++depth)
+      {
+        const IndexValueType begin = m_IORegion.GetIndex(axis) + depth * size;
+        if (begin >= extent)
+        {
+          break;
+        }
+        nextRegion.SetIndex(axis, begin);
+        nextRegion.SetSize(axis, std::min(size, extent - begin));
+        if (readMappedChunks)
+        {
+          AdviseRawChunks(m_TensorStoreData->store,
+                          rawChunkLayout,
+                          mappedChunkDirectory,
+                          this->ConfigureTensorstoreIORegion(nextRegion));
+        }
+        else
+        {
+          this->Prefetch(nextRegion);
+        }
+      }
+      break;
+    }
+  }
+}
+
+void
+OMEZarrNGFFImageIO::Prefetch(const ImageIORegion & region)
+{
+  auto & prefetches = m_TensorStoreData->prefetches;
+  itkAssertOrThrowMacro(m_TensorStoreData->store.valid(), "Image information must be read before prefetching");
+
+  // Without a cache pool the prefetched chunks would be dropped as soon as they are decoded
+  if (!m_TensorStoreData->contextSpec.contains("cache_pool"))
+  {
+    if (!m_TensorStoreData->warnedAboutUncachedPrefetch)
+    {
+      itkWarningMacro(<< "Prefetching is skipped because CachePoolSize is 0. "
+                         "Set a CachePoolSize to serve subsequent reads from prefetched chunks.");
+      m_TensorStoreData->warnedAboutUncachedPrefetch = true;
+    }
+    return;
+  }
+
+  // Release completed prefetches. Pending ones are kept, as releasing a future cancels its read.
+  prefetches.erase(std::remove_if(prefetches.begin(),
+                                  prefetches.end(),
+                                  [](const tensorstore::Future<const void> & prefetch) { return prefetch.ready(); }),
+                   prefetches.end());
+
+  // Bound the memory of the regions being decoded by waiting for the oldest prefetch
+  if (prefetches.size() >= maximumPendingPrefetches)
+  {
+    prefetches.front().Wait();
+    prefetches.erase(prefetches.begin());
+  }
+
+  const auto storeIORegion = this->ConfigureTensorstoreIORegion(region);
+  if (this->GetDebug())
+  {
+    std::cout << "Prefetching " << storeIORegion.GetNumberOfPixels() << " elements from tensorstore region "
+              << storeIORegion;
+  }
+
+  // Only the chunk cache keeps the decoded chunks. The array read is discarded as soon as it is complete,
+  // rather than being held by the pending prefetch until it is released.
+  prefetches.push_back(
+    tensorstore::MapFutureValue(tensorstore::InlineExecutor{},
+                                [](const auto & /* decodedRegion */) {},
+                                tensorstore::Read(SliceStore(m_TensorStoreData->store, storeIORegion))));
+}
+
+void
+OMEZarrNGFFImageIO::ReadRegions(const RegionReadListType & regionReads)
+{
+  const ComponentAxis componentAxis =
+    FindComponentAxis(this->GetAxesInStoreOrder(), m_ChannelsAsComponents, m_ChannelIndices);
+  const auto getLevelStore = [this](int datasetIndex) -> tensorstore::TensorStore<> & {
+    if (datasetIndex >= static_cast<int>(m_TensorStoreData->datasetStores.size()))
+    {
+      itkExceptionMacro(<< "Requested DatasetIndex of " << datasetIndex
+                        << " is out of range for the number of datasets (" << m_TensorStoreData->datasetStores.size()
+                        << ") which exist in OME-NGFF store '" << this->GetFileName() << "'");
+    }
+    return m_TensorStoreData->DatasetStore(datasetIndex);
+  };
+
+  // Each chunk overlapping any region is read once, keyed by resolution level and chunk origin,
+  // and released as soon as the last region overlapping it has been copied
+  using ChunkKey = std::pair<int, std::vector<tensorstore::Index>>;
+  struct ChunkRead
+  {
+    ImageIORegion                                       region{};
+    size_t                                              remainingRegions{ 0 };
+    tensorstore::Future<tensorstore::SharedArray<void>> read{}; // null until started
+  };
+  std::map<ChunkKey, ChunkRead>      chunkReads;
+  std::vector<std::vector<ChunkKey>> regionChunks(regionReads.size());
+  std::vector<RegionBufferLayout>    regionLayouts;
+  for (size_t regionIndex = 0; regionIndex < regionReads.size(); ++regionIndex)
+  {
+    const auto & regionRead = regionReads[regionIndex];
+    itkAssertOrThrowMacro(regionRead.buffer != nullptr, "Missing buffer of a region to read");
+    if (regionRead.region.GetImageDimension() != this->GetNumberOfDimensions())
+    {
+      itkExceptionMacro(<< "Region " << regionIndex << " has " << regionRead.region.GetImageDimension()
+                        << " dimensions, but the image information has " << this->GetNumberOfDimensions());
+    }
+    const int    datasetIndex = regionRead.datasetIndex < 0 ? this->GetDatasetIndex() : regionRead.datasetIndex;
+    const auto & store = getLevelStore(datasetIndex);
+    const auto   storeIORegion = this->ConfigureTensorstoreIORegion(
+      regionRead.region,
+      regionRead.timeIndex == INVALID_INDEX ? m_TimeIndex : regionRead.timeIndex,
+      regionRead.channelIndex == INVALID_INDEX ? m_ChannelIndex : regionRead.channelIndex);
+    regionLayouts.push_back(MakeRegionBufferLayout(storeIORegion, componentAxis));
+
+    const auto                      storeShape = store.domain().shape();
+    const auto                      chunkShape = GetChunkShape(store);
+    const auto                      rank = store.rank();
+    std::vector<tensorstore::Index> gridBegin(rank);
+    std::vector<tensorstore::Index> gridEnd(rank);
+    for (tensorstore::DimensionIndex dim = 0; dim < rank; ++dim)
+    {
+      const tensorstore::Index begin = storeIORegion.GetIndex(dim);
+      const tensorstore::Index end = begin + static_cast<tensorstore::Index>(storeIORegion.GetSize(dim));
+      if (begin < 0 || end > storeShape[dim])
+      {
+        itkExceptionMacro(<< "Region " << regionIndex << " reads store region " << storeIORegion
+                          << ", which exceeds the array of resolution level " << datasetIndex);
+      }
+      gridBegin[dim] = begin / chunkShape[dim];
+      gridEnd[dim] = (end + chunkShape[dim] - 1) / chunkShape[dim];
+    }
+
+    ForEachIndex(gridBegin, gridEnd, [&](const std::vector<tensorstore::Index> & gridIndex) {
+      ImageIORegion                   chunkRegion(rank);
+      std::vector<tensorstore::Index> chunkOrigin(rank);
+      for (tensorstore::DimensionIndex dim = 0; dim < rank; ++dim)
+      {
+        chunkOrigin[dim] = gridIndex[dim] * chunkShape[dim];
+        chunkRegion.SetIndex(dim, chunkOrigin[dim]);
+        chunkRegion.SetSize(dim, std::min(chunkShape[dim], storeShape[dim] - chunkOrigin[dim]));
+      }
+      ChunkKey    key{ datasetIndex, chunkOrigin };
+      ChunkRead & chunkRead = chunkReads[key];
+      chunkRead.region = chunkRegion;
+      ++chunkRead.remainingRegions;
+      regionChunks[regionIndex].push_back(std::move(key));
+    });
+  }
+
+  // Chunk reads are started in region order, ahead of the region being copied while fewer than
+  // maximumRegionReadChunks chunks are held, so that memory does not grow with the size of the batch
+  size_t     startedRegions = 0;
+  size_t     heldChunks = 0;
+  const auto startChunkReads = [&](size_t regionIndex) {
+    for (const auto & key : regionChunks[regionIndex])
+    {
+      ChunkRead & chunkRead = chunkReads.at(key);
+      if (chunkRead.read.null())
+      {
+        chunkRead.read =
+          tensorstore::Read<tensorstore::zero_origin>(SliceStore(getLevelStore(key.first), chunkRead.region));
+        ++heldChunks;
+      }
+    }
+  };
+  for (size_t regionIndex = 0; regionIndex < regionReads.size(); ++regionIndex)
+  {
+    while (startedRegions < regionReads.size() &&
+           (startedRegions <= regionIndex || heldChunks < maximumRegionReadChunks))
+    {
+      startChunkReads(startedRegions++);
+    }
+
+    // Copy each chunk into the region as it completes
+    for (const auto & key : regionChunks[regionIndex])
+    {
+      const auto chunkRead = chunkReads.find(key);
+      CopyChunkToRegion(ValueOrThrow(chunkRead->second.read.result()),
+                        key.second,
+                        regionLayouts[regionIndex],
+                        regionReads[regionIndex].buffer);
+      if (--chunkRead->second.remainingRegions == 0)
+      {
+        chunkReads.erase(chunkRead);
+        --heldChunks;
+      }
+    }
+  }
+}
+
+unsigned
+OMEZarrNGFFImageIO::GetNumberOfDatasets() const
+{
+  if (m_TensorStoreData->multiscaleFileName != this->GetGroupPath())
+  {
+    return 0; // the image information read is of another store
+  }
+  return m_TensorStoreData->datasetGeometries.size();
+}
+
+std::vector<SizeValueType>
+OMEZarrNGFFImageIO::GetDatasetDimensions(unsigned datasetIndex) const
+{
+  this->RecordDatasetGeometry(datasetIndex);
+  return GetDatasetGeometry(m_TensorStoreData->datasetGeometries, datasetIndex).dimensions;
+}
+
+std::vector<double>
+OMEZarrNGFFImageIO::GetDatasetSpacing(unsigned datasetIndex) const
+{
+  this->RecordDatasetGeometry(datasetIndex);
+  return GetDatasetGeometry(m_TensorStoreData->datasetGeometries, datasetIndex).spacing;
+}
+
+std::vector<double>
+OMEZarrNGFFImageIO::GetDatasetOrigin(unsigned datasetIndex) const
+{
+  this->RecordDatasetGeometry(datasetIndex);
+  return GetDatasetGeometry(m_TensorStoreData->datasetGeometries, datasetIndex).origin;
+}
+
+double
+OMEZarrNGFFImageIO::GetLastReadStatistic(ReadStatisticEnum statistic) const
+{
+  return m_TensorStoreData->lastReadStatistics.at(static_cast<size_t>(statistic));
+}
+
+double
+OMEZarrNGFFImageIO::GetCumulativeReadStatistic(ReadStatisticEnum statistic) const
+{
+  return m_TensorStoreData->cumulativeReadStatistics.at(static_cast<size_t>(statistic));
+}
+
+void
+OMEZarrNGFFImageIO::ResetReadStatistics()
+{
+  m_TensorStoreData->lastReadStatistics.fill(0.0);
+  m_TensorStoreData->cumulativeReadStatistics.fill(0.0);
+}
+
+void
+OMEZarrNGFFImageIO::WaitForPrefetches()
+{
+  // Read errors are left to be reported by a subsequent `Read` of the region
+  for (const auto & prefetch : m_TensorStoreData->prefetches)
+  {
+    prefetch.Wait();
+  }
+  m_TensorStoreData->prefetches.clear();
+}
+
+
+bool
+OMEZarrNGFFImageIO::CanWriteFile(const char * name)
 {
-  const auto storeRank = m_TensorStoreData->store.rank(); 
+  return this->HasSupportedWriteExtension(name, true);
+}
 
-  // Set up IO region to match known store dimensions
-  itkAssertOrThrowMacro(m_StoreAxes.size() == storeRank, "Detected mismatch in axis count and store rank");
-  ImageIORegion storeRegion(storeRank);
-  itkAssertOrThrowMacro(storeRegion.GetImageDimension(), storeRank);
-  auto storeAxes = this->GetAxesInStoreOrder();
 
-  for (size_t storeIndex = 0; storeIndex < storeRank; ++storeIndex)
+void
+OMEZarrNGFFImageIO::WriteImageInformation()
+{
+  const std::string fileName = this->GetFileName();
+  std::string       driver = getKVstoreDriver(fileName);
+  this->UpdateTensorStoreContext();
+  InvalidateMetadataCache(this->GetFileName());
+
+  // Label images are written into the "labels" group of an existing image, next to its arrays,
+  // and in the zarr format of the image whatever the extension of its name
+  const std::string groupPath = this->GetGroupPath();
+  unsigned          zarrFormat = ResolveZarrFormat(m_ZarrFormat, fileName);
+  if (!m_LabelName.empty())
   {
-    auto axisName = storeAxes.at(storeIndex).name;
-
-    // Optionally slice time or channel indices
-    if (axisName == "t")
-    {
-      storeRegion.SetSize(storeIndex, 1);
-      if (m_TimeIndex == INVALID_INDEX)
-      {
-        itkWarningMacro(<< "The OME-Zarr store contains a time \"t\" axis but no time point has been specified. "
-                           "Reading along a time axis is not currently supported. Data will be read from the first "
-                           "available time point by default.");
-        storeRegion.SetIndex(storeIndex, 0);
-      }
-      else
-      {
-        storeRegion.SetIndex(storeIndex, m_TimeIndex);
-      }
-    }
-    else if (axisName == "c")
+    if (m_LabelName == "." || m_LabelName == ".." || m_LabelName.find_first_of("/\\") != std::string::npos)
     {
-      storeRegion.SetSize(storeIndex, 1);
-      if (m_ChannelIndex == INVALID_INDEX)
-      {
-        itkWarningMacro(<< "The OME-Zarr store contains a channel \"c\" axis but no channel index has been specified. "
-                           "Reading along a channel axis is not currently supported. Data will be read from the first "
-                           "available channel by default.");
-        storeRegion.SetIndex(storeIndex, 0);
-      }
-      else
-      {
-        storeRegion.SetIndex(storeIndex, m_ChannelIndex);
-      }
+      itkExceptionMacro("Invalid label name '" << m_LabelName << "', which must name a single group");
     }
-    // Set requested region on X/Y/Z axes
-    else if (axisName == "x")
+    if (driver == "zip_memory")
     {
-      itkAssertOrThrowMacro(ioRegion.GetImageDimension() >= 1, "Failed to read from \"x\" axis into ITK axis \"0\"");
-      storeRegion.SetSize(storeIndex, ioRegion.GetSize(0));
-      storeRegion.SetIndex(storeIndex, ioRegion.GetIndex(0));
+      itkExceptionMacro("Label images cannot be written into zip store '" << fileName << "'");
     }
-    else if (axisName == "y")
+    const unsigned imageFormat = DetectZarrFormat(fileName, driver, m_TensorStoreData->tsContext);
+    if (imageFormat == 0)
     {
-      itkAssertOrThrowMacro(ioRegion.GetImageDimension() >= 2, "Failed to read from \"y\" axis into ITK axis \"1\"");
-      storeRegion.SetSize(storeIndex, ioRegion.GetSize(1));
-      storeRegion.SetIndex(storeIndex, ioRegion.GetIndex(1));
+      itkExceptionMacro("Label image '" << m_LabelName << "' must be written into an existing image at " << fileName);
     }
-    else if (axisName == "z")
+    if (m_ZarrFormat != 0 && m_ZarrFormat != imageFormat)
     {
-      itkAssertOrThrowMacro(ioRegion.GetImageDimension() >= 3, "Failed to read from \"z\" axis into ITK axis \"2\"");
-      storeRegion.SetSize(storeIndex, ioRegion.GetSize(2));
-      storeRegion.SetIndex(storeIndex, ioRegion.GetIndex(2));
+      itkExceptionMacro("Zarr format " << m_ZarrFormat << " was requested for label image '" << m_LabelName
+                                       << "', but its image has zarr format " << imageFormat);
     }
+    zarrFormat = imageFormat;
+  }
+  if (zarrFormat != 2 && zarrFormat != 3)
+  {
+    itkExceptionMacro("Unsupported zarr format " << zarrFormat << ", expected 2 or 3");
   }
 
-  return storeRegion;
-}
+  // Zip stores are staged in memory until their archive is written after the last region
+  if (driver == "zip_memory")
+  {
+    driver = zipStagingDriver;
+
+    // The staged entries live in the memory kvstore of this context, which is kept until the archive
+    // is written even if the context of this ImageIO is replaced in the meantime
+    m_TensorStoreData->zipStagingContext = m_TensorStoreData->tsContext;
+    auto clearFuture =
+      tensorstore::kvstore::DeleteRange(OpenZipStaging(fileName, m_TensorStoreData->zipStagingContext), {});
+    TS_EVAL_CHECK(clearFuture);
+  }
 
-void
-OMEZarrNGFFImageIO::ReadImageInformation()
-{
-  nlohmann::json json;
-  std::string    driver = getKVstoreDriver(this->GetFileName());
+  unsigned dim = this->GetNumberOfDimensions();
 
-  const std::string zgroupFilePath(std::string(this->GetFileName()) + "/.zgroup");
-  bool              status = jsonRead(zgroupFilePath, json, driver, m_TensorStoreData->tsContext);
-  itkAssertOrThrowMacro(status, ("Failed to read from " + zgroupFilePath));
-  itkAssertOrThrowMacro(json.at("zarr_format").get<int>() == 2, "Only v2 zarr format is supported"); // only v2 for now
+  std::vector<double>      origin(dim);
+  std::vector<double>      spacing(dim);
+  std::vector<std::string> storeAxisNames(dim);
 
-  const std::string zattrsFilePath(std::string(this->GetFileName()) + "/.zattrs");
-  status = jsonRead(zattrsFilePath, json, driver, m_TensorStoreData->tsContext);
-  itkAssertOrThrowMacro(status, ("Failed to read from " + zattrsFilePath));
-  json = json.at("multiscales")[0]; // multiscales must be present in OME-NGFF
-  auto version = json.at("version").get<std::string>();
-  if (version == "0.4" || version == "0.3" || version == "0.2" || version == "0.1")
+  std::vector<nlohmann::json> axes(dim);
+  for (unsigned d = 0; d < dim; ++d)
   {
-    // these are explicitly supported versions
+    // reverse indices IJK into KJI
+    nlohmann::json dAxis = { { "name", this->dimensionNames[dim - d - 1] },
+                             { "type", this->dimensionTypes[dim - d - 1] },
+                             { "unit", this->dimensionUnits[dim - d - 1] } };
+    axes[d] = dAxis;
+    origin[d] = this->GetOrigin(dim - d - 1);
+    spacing[d] = this->GetSpacing(dim - d - 1);
+    storeAxisNames[d] = this->dimensionNames[dim - d - 1];
   }
-  else
+  const auto downsampleFactors = MakeDownsampleFactors(storeAxisNames);
+
+  // Level `l` samples blocks of `factor^l` voxels. Averaging methods place the
+  // sample at the block center, while striding keeps the first voxel of the block.
+  std::vector<nlohmann::json> datasets;
+  for (unsigned level = 0; level < m_NumberOfResolutionLevels; ++level)
   {
-    std::string message = "OME-NGFF version " + version + " is not explicitly supported." +
-                          "\nImportant features might be ignored." + "\nSupported versions are 0.1 through 0.4.";
-    OutputWindowDisplayWarningText(message.c_str());
+    std::vector<double> levelOrigin(origin);
+    std::vector<double> levelSpacing(spacing);
+    for (unsigned d = 0; d < dim; ++d)
+    {
+      const double blockSize = std::pow(static_cast<double>(downsampleFactors[d]), level);
+      levelSpacing[d] = spacing[d] * blockSize;
+      if (this->GetLevelDownsamplingMethod() != DownsamplingMethodEnum::Stride)
+      {
+        levelOrigin[d] = origin[d] + 0.5 * (blockSize - 1.0) * spacing[d];
+      }
+    }
+    datasets.push_back({ { "coordinateTransformations",
+                           { { { "scale", levelSpacing }, { "type", "scale" } },
+                             { { "translation", levelOrigin }, { "type", "translation" } } } },
+                         { "path", MakePath(this->GetDatasetIndex() + level) } });
   }
 
-  if (json.contains("axes")) // optional before 0.3
-  {
-    this->InitializeIdentityMetadata(json.at("axes").size());
+  // TODO: add stuff from metadata dictionary into "metadata" object
 
-    m_StoreAxes.resize(json.at("axes").size());
-    auto targetIt = m_StoreAxes.rbegin();
-    for (const auto & axis : json.at("axes"))
+  if (zarrFormat == 3)
+  {
+    // OME-NGFF 0.5 nests its metadata under "ome" in the zarr v3 group attributes
+    nlohmann::json multiscales = {
+      { { "axes", axes }, { "datasets", datasets } },
+    };
+    nlohmann::json ome = { { "version", "0.5" }, { "multiscales", multiscales } };
+    if (!m_LabelName.empty())
     {
-      *targetIt = (OMEZarrNGFFAxis{ axis.at("name"), axis.at("type"), (axis.contains("unit") ? axis.at("unit") : "") });
-      ++targetIt;
+      ome["image-label"] = { { "source", { { "image", "../../" } } } };
     }
-    itkAssertOrThrowMacro(targetIt == m_StoreAxes.rend(),
-                          "Internal error: failed to fully parse axes from OME-Zarr metadata");
+    nlohmann::json group = { { "zarr_format", 3 }, { "node_type", "group" }, { "attributes", { { "ome", ome } } } };
+    writeJson(group, groupPath + "/zarr.json", driver, m_TensorStoreData->tsContext);
   }
   else
   {
-    if (version == "0.4")
+    nlohmann::json group;
+    group["zarr_format"] = 2;
+    writeJson(group, groupPath + "/.zgroup", driver, m_TensorStoreData->tsContext);
+
+    nlohmann::json multiscales = {
+      { { "axes", axes }, { "datasets", datasets }, { "version", "0.4" } },
+    };
+    nlohmann::json zattrs;
+    zattrs["multiscales"] = multiscales;
+    if (!m_LabelName.empty())
     {
-      itkExceptionMacro(<< "\"axes\" field is missing from OME-Zarr image metadata at " << zattrsFilePath);
+      zattrs["image-label"] = { { "version", "0.4" }, { "source", { { "image", "../../" } } } };
     }
-    this->SetNumberOfDimensions(0);
+    writeJson(zattrs, groupPath + "/.zattrs", driver, m_TensorStoreData->tsContext);
   }
 
-  if (json.contains("coordinateTransformations")) // optional
+  // List the label image in the "labels" group, keeping the labels written before
+  if (!m_LabelName.empty())
+  {
+    std::vector<std::string> labelNames = this->GetLabelNames();
+    if (std::find(labelNames.begin(), labelNames.end(), m_LabelName) == labelNames.end())
+    {
+      labelNames.push_back(m_LabelName);
+    }
+    const std::string labelsPath = fileName + "/labels";
+    if (zarrFormat == 3)
+    {
+      const nlohmann::json ome = { { "version", "0.5" }, { "labels", labelNames } };
+      const nlohmann::json group = {
+        { "zarr_format", 3 }, { "node_type", "group" }, { "attributes", { { "ome", ome } } }
+      };
+      writeJson(group, labelsPath + "/zarr.json", driver, m_TensorStoreData->tsContext);
+    }
+    else
+    {
+      writeJson({ { "zarr_format", 2 } }, labelsPath + "/.zgroup", driver, m_TensorStoreData->tsContext);
+      writeJson({ { "labels", labelNames } }, labelsPath + "/.zattrs", driver, m_TensorStoreData->tsContext);
+    }
+    InvalidateMetadataCache(labelsPath);
+  }
+
+  // Create the arrays once so that streamed `Write` calls only fill in their own IO region
+  const IOComponentEnum componentType{ this->GetComponentType() };
+  std::string           dtype;
+  if (!TryToMakeZarrDType(supportedPixelTypes, componentType, dtype))
   {
-    addCoordinateTransformations(this, json.at("coordinateTransformations")); // dataset-level scaling
+    itkExceptionMacro("Unsupported component type: " << GetComponentTypeAsString(componentType));
   }
-  json = json.at("datasets");
-  if (this->GetDatasetIndex() >= json.size())
+
+  std::vector<int64_t> shape(dim);
+  for (unsigned d = 0; d < dim; ++d)
   {
-    itkExceptionMacro(<< "Requested DatasetIndex of " << this->GetDatasetIndex()
-                      << " is out of range for the number of datasets (" << json.size()
-                      << ") which exist in OME-NGFF store '" << this->GetFileName() << "'");
+    auto dSize = this->GetDimensions(d);
+    if (dSize > std::numeric_limits<int64_t>::max())
+    {
+      itkExceptionMacro("This image IO uses a signed type for sizes, and "
+                        << dSize << " exceeds maximum allowed size of " << std::numeric_limits<int64_t>::max());
+    }
+    shape[dim - 1 - d] = dSize; // convert IJK into KJI
   }
 
-  json = json[this->GetDatasetIndex()];
-  if (json.contains("coordinateTransformations")) // optional for versions prior to 0.4
+  // Label IDs form long runs of few distinct values, which zstd packs much tighter than lz4
+  std::string compressorName = this->GetCompressor();
+  if (compressorName.empty() && !m_LabelName.empty())
   {
-    addCoordinateTransformations(this, json.at("coordinateTransformations")); // per-resolution scaling
+    compressorName = "BLOSC_ZSTD";
   }
-  else
+  const nlohmann::json compressor =
+    MakeZarrCompressor(compressorName, this->GetCompressionLevel(), this->GetComponentSize());
+
+  m_TensorStoreData->levelStores.clear();
+  for (unsigned level = 0; level < m_NumberOfResolutionLevels; ++level)
   {
-    if (version == "0.4")
+    if (level > 0)
     {
-      itkExceptionMacro(<< "OME-NGFF v0.4 requires `coordinateTransformations` for each resolution level.");
+      for (unsigned d = 0; d < dim; ++d)
+      {
+        shape[d] = (shape[d] + downsampleFactors[d] - 1) / downsampleFactors[d];
+      }
     }
-  }
+    const std::vector<int64_t> chunks =
+      MakeChunkShape(m_ChunkShape, shape, storeAxisNames, this->GetComponentSize(), m_TargetChunkSizeInBytes);
 
-  // TODO: parse stuff from "metadata" object into metadata dictionary
+    nlohmann::json spec = {
+      { "kvstore", { { "driver", driver }, { "path", groupPath + "/" + MakePath(this->GetDatasetIndex() + level) } } },
+    };
+    if (zarrFormat == 3)
+    {
+      // Sharding packs the chunks of each shard into a single object, with an index of the chunks at its end
+      nlohmann::json codecs = MakeZarr3Codecs(compressorName, this->GetCompressionLevel(), this->GetComponentSize());
+      std::vector<int64_t> gridShape = chunks;
+      if (!m_ShardShape.empty())
+      {
+        gridShape = MakeShardShape(m_ShardShape, shape, chunks);
+        const nlohmann::json indexCodecs = nlohmann::json::array(
+          { { { "name", "bytes" }, { "configuration", { { "endian", "little" } } } }, { { "name", "crc32c" } } });
+        const nlohmann::json shardingCodec = { { "name", "sharding_indexed" },
+                                               { "configuration",
+                                                 { { "chunk_shape", chunks },
+                                                   { "codecs", codecs },
+                                                   { "index_codecs", indexCodecs },
+                                                   { "index_location", "end" } } } };
+        codecs = nlohmann::json::array({ shardingCodec });
+      }
+      spec["driver"] = "zarr3";
+      spec["metadata"] = {
+        { "data_type", std::string(itkToTensorstoreComponentType(componentType).name()) },
+        { "shape", shape },
+        { "chunk_grid", { { "name", "regular" }, { "configuration", { { "chunk_shape", gridShape } } } } },
+        { "chunk_key_encoding", { { "name", "default" } } },
+        { "codecs", codecs },
+        { "dimension_names", storeAxisNames },
+      };
+    }
+    else
+    {
+      spec["driver"] = "zarr";
+      spec["metadata"] = {
+        { "compressor", compressor },
+        { "dtype", dtype },
+        { "shape", shape },
+        { "chunks", chunks },
+      };
+    }
 
-  ReadArrayMetadata(std::string(this->GetFileName()) + "/" + json.at("path").get<std::string>(), driver);
+    auto openFuture = tensorstore::Open(
+      spec,
+      m_TensorStoreData->tsContext,
+      tensorstore::OpenMode::create | tensorstore::OpenMode::delete_existing,
+      tensorstore::ReadWriteMode::read_write);
+    TS_EVAL_CHECK(openFuture);
+    m_TensorStoreData->levelStores.push_back(openFuture.value());
+  }
+  m_TensorStoreData->levelDownsampleFactors = InferLevelDownsampleFactors(m_TensorStoreData->levelStores);
+  m_TensorStoreData->store = m_TensorStoreData->levelStores.front();
+  m_TensorStoreData->writeFileName = groupPath;
+  m_TensorStoreData->ClearReadState();
 }
 
+
 void
-OMEZarrNGFFImageIO::Read(void * buffer)
+OMEZarrNGFFImageIO::OpenArraysForRegionWrite()
 {
-  // Use a proxy measure (voxel count) to determine whether we are reading
-  // the entire image or an image subregion.
-  // This comparison needs to be done carefully, we can compare 3D and 6D regions
-  if (this->GetLargestRegion().GetNumberOfPixels() == m_IORegion.GetNumberOfPixels())
+  const std::string fileName = this->GetFileName();
+  const std::string groupPath = this->GetGroupPath();
+  if (m_TensorStoreData->writeFileName == groupPath &&
+      m_TensorStoreData->levelStores.size() == m_NumberOfResolutionLevels)
   {
-    itkAssertOrThrowMacro(m_TensorStoreData->store.domain().num_elements() == m_IORegion.GetNumberOfPixels(),
-                          "Detected mismatch between store size and size of largest possible region");
+    return;
   }
-  else
+
+  const std::string driver = getKVstoreDriver(fileName);
+  if (driver == "zip_memory")
   {
-    // Get a requested image subregion
-    itkAssertOrThrowMacro(this->GetNumberOfComponents() == 1,
-                          "Reading an image subregion is currently supported only for single channel images");
+    itkExceptionMacro("Writing regions into an existing zip store is not supported");
   }
-  auto storeIORegion = this->ConfigureTensorstoreIORegion(m_IORegion);
+  this->UpdateTensorStoreContext();
 
-  if (this->GetDebug())
+  // The arrays are opened in the format of the existing group, whatever the extension of its name
+  const unsigned detectedFormat = DetectZarrFormat(groupPath, driver, m_TensorStoreData->tsContext);
+  if (detectedFormat != 0 && m_ZarrFormat != 0 && detectedFormat != m_ZarrFormat)
   {
-    std::cout << "Preparing to read " << storeIORegion.GetNumberOfPixels() << " elements from tensorstore region "
-              << storeIORegion;
+    itkExceptionMacro("Zarr format " << m_ZarrFormat << " was requested, but " << groupPath << " has zarr format "
+                                     << detectedFormat);
   }
-
-  if (const IOComponentEnum componentType{ this->GetComponentType() };
-      !TryToReadFromStore(supportedPixelTypes, componentType, m_TensorStoreData->store, storeIORegion, buffer))
+  const unsigned zarrFormat = detectedFormat != 0 ? detectedFormat : ResolveZarrFormat(m_ZarrFormat, fileName);
+  if (zarrFormat != 2 && zarrFormat != 3)
   {
-    itkExceptionMacro("Unsupported component type: " << GetComponentTypeAsString(componentType));
+    itkExceptionMacro("Unsupported zarr format " << zarrFormat << ", expected 2 or 3");
   }
-}
 
-
-bool
-OMEZarrNGFFImageIO::CanWriteFile(const char * name)
-{
-  return this->HasSupportedWriteExtension(name, true);
+  // Open all levels at once. Unlike in `WriteImageInformation`, existing arrays and their chunks are kept, and
+  // tensorstore merges regions covering chunks partially with the stored chunks.
+  std::vector<tensorstore::Future<tensorstore::TensorStore<>>> openFutures;
+  for (unsigned level = 0; level < m_NumberOfResolutionLevels; ++level)
+  {
+    const nlohmann::json spec = {
+      { "driver", zarrFormat == 3 ? "zarr3" : "zarr" },
+      { "kvstore", MakeKVStoreSpec(driver, groupPath, MakePath(this->GetDatasetIndex() + level)) },
+    };
+    openFutures.push_back(tensorstore::Open(
+      spec, m_TensorStoreData->tsContext, tensorstore::OpenMode::open, tensorstore::ReadWriteMode::read_write));
+  }
+  m_TensorStoreData->writeFileName.clear();
+  m_TensorStoreData->levelStores.clear();
+  m_TensorStoreData->levelDownsampleFactors.clear();
+  for (auto & openFuture : openFutures)
+  {
+    TS_EVAL_CHECK(openFuture);
+    m_TensorStoreData->levelStores.push_back(openFuture.value());
+  }
+  // The factors between levels are taken from the array shapes, as the levels may have been written by
+  // other tools with other factors than this ImageIO uses, e.g. without downsampling the z axis
+  m_TensorStoreData->levelDownsampleFactors = InferLevelDownsampleFactors(m_TensorStoreData->levelStores);
+  m_TensorStoreData->store = m_TensorStoreData->levelStores.front();
+  m_TensorStoreData->hasRawChunks = false; // the raw chunk layout described the array read
+
+  // The image information set for writing must describe the array created earlier
+  const unsigned dim = this->GetNumberOfDimensions();
+  const auto     shape = m_TensorStoreData->store.domain().shape();
+  bool           matches = shape.size() == static_cast<tensorstore::Index>(dim) &&
+               m_TensorStoreData->store.dtype() == itkToTensorstoreComponentType(this->GetComponentType());
+  for (unsigned d = 0; matches && d < dim; ++d)
+  {
+    matches = shape[dim - 1 - d] == static_cast<tensorstore::Index>(this->GetDimensions(d));
+  }
+  if (!matches)
+  {
+    itkExceptionMacro("The " << dim << "D image of " << GetComponentTypeAsString(this->GetComponentType())
+                             << " does not match the existing array " << m_TensorStoreData->store.domain() << " of "
+                             << m_TensorStoreData->store.dtype() << " in " << groupPath);
+  }
+  m_TensorStoreData->writeFileName = groupPath;
 }
 
-
 void
-OMEZarrNGFFImageIO::WriteImageInformation()
+OMEZarrNGFFImageIO::UpdateResolutionLevels(const ImageIORegion & modifiedRegion)
 {
-  std::string driver = getKVstoreDriver(this->GetFileName());
-
-  nlohmann::json group;
-  group["zarr_format"] = 2;
-  writeJson(group, std::string(this->GetFileName()) + "/.zgroup", driver, m_TensorStoreData->tsContext);
-
-  unsigned dim = this->GetNumberOfDimensions();
-
-  std::vector<double> origin(dim);
-  std::vector<double> spacing(dim);
-
-  std::vector<nlohmann::json> axes(dim);
-  for (unsigned d = 0; d < dim; ++d)
+  const std::string fileName = this->GetFileName();
+  const std::string groupPath = this->GetGroupPath();
+  itkAssertOrThrowMacro(m_TensorStoreData->multiscaleFileName == groupPath && m_TensorStoreData->store.valid(),
+                        "Image information must be read before updating resolution levels");
+  const std::string driver = getKVstoreDriver(fileName);
+  if (driver != "file")
   {
-    // reverse indices IJK into KJI
-    nlohmann::json dAxis = { { "name", this->dimensionNames[dim - d - 1] },
-                             { "type", this->dimensionTypes[dim - d - 1] },
-                             { "unit", this->dimensionUnits[dim - d - 1] } };
-    axes[d] = dAxis;
-    origin[d] = this->GetOrigin(dim - d - 1);
-    spacing[d] = this->GetSpacing(dim - d - 1);
+    itkExceptionMacro("Updating the resolution levels of '" << fileName << "' is only supported for local stores");
   }
 
-  nlohmann::json datasets = { { "coordinateTransformations",
-                                { { { "scale", spacing }, { "type", "scale" } },
-                                  { { "translation", origin }, { "type", "translation" } } } },
-                              { "path", MakePath(this->GetDatasetIndex()) } };
-
-  nlohmann::json multiscales = {
-    { { "axes", axes }, { "datasets", { datasets } }, { "version", "0.4" } },
-  };
+  // Open the modified level and all coarser ones for writing, in the zarr format detected when reading
+  // the information and in the context it was read with. Without a cache pool in that context, a bounded
+  // one holds the chunks of each level written for downsampling them into the next.
+  tensorstore::Context context = m_TensorStoreData->tsContext;
+  if (!m_TensorStoreData->contextSpec.contains("cache_pool"))
+  {
+    nlohmann::json spec = m_TensorStoreData->contextSpec;
+    spec["cache_pool"] = { { "total_bytes_limit", streamingCachePoolSize } };
+    context = MakeContext(spec);
+  }
+  const auto &                                                 datasetPaths = m_TensorStoreData->datasetPaths;
+  std::vector<tensorstore::Future<tensorstore::TensorStore<>>> openFutures;
+  for (auto datasetIndex = static_cast<size_t>(this->GetDatasetIndex()); datasetIndex < datasetPaths.size();
+       ++datasetIndex)
+  {
+    const nlohmann::json spec = {
+      { "driver", m_TensorStoreData->zarrDriver },
+      { "kvstore", MakeKVStoreSpec(driver, groupPath, datasetPaths[datasetIndex]) },
+    };
+    openFutures.push_back(
+      tensorstore::Open(spec, context, tensorstore::OpenMode::open, tensorstore::ReadWriteMode::read_write));
+  }
+  std::vector<tensorstore::TensorStore<>> levelStores;
+  for (auto & openFuture : openFutures)
+  {
+    TS_EVAL_CHECK(openFuture);
+    levelStores.push_back(openFuture.value());
+  }
+  if (levelStores.size() < 2)
+  {
+    return;
+  }
 
-  // TODO: add stuff from metadata dictionary into "metadata" object
+  // The factors between levels are taken from the array shapes, as the multiscale
+  // metadata does not need to be written by this ImageIO
+  const auto levelDownsampleFactors = InferLevelDownsampleFactors(levelStores);
 
-  nlohmann::json zattrs;
-  zattrs["multiscales"] = multiscales;
-  writeJson(zattrs, std::string(this->GetFileName()) + "/.zattrs", driver, m_TensorStoreData->tsContext);
+  const auto storeIORegion = this->ConfigureTensorstoreIORegion(modifiedRegion);
+  if (this->GetDebug())
+  {
+    std::cout << "Updating " << levelStores.size() - 1 << " resolution levels from tensorstore region "
+              << storeIORegion;
+  }
+  PropagateToResolutionLevels(levelStores,
+                              storeIORegion,
+                              levelDownsampleFactors,
+                              ToTensorstoreDownsampleMethod(this->GetLevelDownsamplingMethod()));
 }
 
-
 void
 OMEZarrNGFFImageIO::Write(const void * buffer)
 {
-  if (m_FileName.substr(m_FileName.size() - 4) == ".zip" || m_FileName.substr(m_FileName.size() - 7) == ".memory")
+  const bool     isZip = getKVstoreDriver(m_FileName) == "zip_memory";
+  const unsigned dim = this->GetNumberOfDimensions();
+  itkAssertOrThrowMacro(m_IORegion.GetImageDimension() == dim, "Detected mismatch in IO region and image dimension");
+
+  // ImageFileWriter streams regions in order, so the first region starts at
+  // the image origin and the last region ends at the image bounds.
+  bool isFirstRegion = true;
+  bool isLastRegion = true;
+  for (unsigned d = 0; d < dim; ++d)
+  {
+    isFirstRegion &= (m_IORegion.GetIndex(d) == 0);
+    isLastRegion &= (m_IORegion.GetIndex(d) + static_cast<IndexValueType>(m_IORegion.GetSize(d)) ==
+                     static_cast<IndexValueType>(this->GetDimensions(d)));
+  }
+
+  if (m_WriteMode == WriteModeEnum::RegionWrite || m_WriteMode == WriteModeEnum::Update)
+  {
+    this->OpenArraysForRegionWrite();
+  }
+  else if (isFirstRegion)
+  {
+    this->WriteImageInformation();
+  }
+  else if (m_TensorStoreData->writeFileName != this->GetGroupPath())
   {
-    m_TensorStoreData->tsContext = tensorstore::Context::Default(); // start with clean zip handles
+    itkExceptionMacro("Streamed writing to '" << m_FileName << "' must begin with the region at the image origin");
   }
-  this->WriteImageInformation();
 
   const IOComponentEnum componentType{ this->GetComponentType() };
 
@@ -830,36 +3894,59 @@ OMEZarrNGFFImageIO::Write(const void * buffer)
     itkExceptionMacro("Unsupported component type: " << GetComponentTypeAsString(componentType));
   }
 
-  std::vector<int64_t> shape(this->GetNumberOfDimensions());
-  for (unsigned d = 0; d < shape.size(); ++d)
+  ImageIORegion storeIORegion(dim);
+  for (unsigned d = 0; d < dim; ++d)
   {
-    auto dSize = this->GetDimensions(d);
-    if (dSize > std::numeric_limits<int64_t>::max())
+    // convert IJK into KJI
+    storeIORegion.SetIndex(dim - 1 - d, m_IORegion.GetIndex(d));
+    storeIORegion.SetSize(dim - 1 - d, m_IORegion.GetSize(d));
+  }
+
+  if (m_WriteMode == WriteModeEnum::RegionWrite)
+  {
+    // Concurrent writers must not share a chunk, as each would overwrite the chunk with its own part of it
+    const std::string unsafety = DescribeUnsafeRegionWrite(
+      m_TensorStoreData->levelStores, storeIORegion, m_TensorStoreData->levelDownsampleFactors);
+    if (!unsafety.empty())
     {
-      itkExceptionMacro("This image IO uses a signed type for sizes, and "
-                        << dSize << " exceeds maximum allowed size of " << std::numeric_limits<int64_t>::max());
+      itkExceptionMacro("IO region " << m_IORegion << " cannot be written concurrently to " << m_FileName
+                                     << ", as its " << unsafety);
     }
-    shape[shape.size() - 1 - d] = dSize; // convert IJK into KJI
   }
 
-  if (!TryToWriteToStore(supportedPixelTypes,
-                         componentType,
-                         m_TensorStoreData->store,
-                         m_TensorStoreData->tsContext,
-                         m_FileName,
-                         MakePath(this->GetDatasetIndex()),
-                         shape,
-                         buffer))
+  if (this->GetDebug())
+  {
+    std::cout << "Preparing to write " << storeIORegion.GetNumberOfPixels() << " elements to tensorstore region "
+              << storeIORegion;
+  }
+
+  if (!TryToWriteToStore(supportedPixelTypes, componentType, m_TensorStoreData->store, storeIORegion, buffer))
   {
     itkExceptionMacro("Unsupported component type: " << GetComponentTypeAsString(componentType));
   }
 
-  if (m_FileName.substr(m_FileName.size() - 4) == ".zip" || m_FileName.substr(m_FileName.size() - 7) == ".memory")
+  if (m_TensorStoreData->levelStores.size() > 1)
+  {
+    PropagateToResolutionLevels(m_TensorStoreData->levelStores,
+                                storeIORegion,
+                                m_TensorStoreData->levelDownsampleFactors,
+                                ToTensorstoreDownsampleMethod(this->GetLevelDownsamplingMethod()));
+  }
+
+  if (m_WriteMode == WriteModeEnum::RegionWrite || m_WriteMode == WriteModeEnum::Update)
+  {
+    // Metadata and arrays read from the store before may be cached along with the chunks rewritten here
+    InvalidateMetadataCache(m_FileName);
+    m_TensorStoreData->ClearReadState();
+  }
+
+  if (isZip && isLastRegion)
   {
-    // Attempt to read a non-existent file from the in-memory zip to close the current one
-    nlohmann::json temp;
-    bool           wasRead = jsonRead(m_EmptyZipFileName + "/non-existent.json", temp, "zip_memory", m_TensorStoreData->tsContext);
-    assert(wasRead == false);
+    WriteZipArchive(m_FileName, m_TensorStoreData->zipStagingContext);
+    m_TensorStoreData->zipStagingContext = tensorstore::Context();
+    m_TensorStoreData->writeFileName.clear();
+    m_TensorStoreData->levelStores.clear();
+    m_TensorStoreData->levelDownsampleFactors.clear();
   }
 }
 
@@ -867,8 +3954,91 @@ OMEZarrNGFFImageIO::Write(const void * buffer)
 ImageIORegion
 OMEZarrNGFFImageIO::GenerateStreamableReadRegionFromRequestedRegion(const ImageIORegion & requestedRegion) const
 {
-  // Propagate the requested region
-  return requestedRegion;
+  const auto & store = m_TensorStoreData->store;
+  if (!m_ChunkAlignedStreaming || m_StoreAxes.empty() || m_StoreAxes.size() != static_cast<size_t>(store.rank()))
+  {
+    // Propagate the requested region
+    return requestedRegion;
+  }
+
+  // Grow the requested region out to the chunk grid along spatial axes.
+  // Store axes are matched to ITK axes by name as in `ConfigureTensorstoreIORegion`.
+  // Zarr chunk grids are always anchored at the store origin.
+  const auto    chunkShape = GetChunkShape(store);
+  const auto    storeShape = store.domain().shape();
+  const auto    storeAxes = this->GetAxesInStoreOrder();
+  ImageIORegion streamableRegion(requestedRegion);
+  for (size_t storeIndex = 0; storeIndex < storeAxes.size(); ++storeIndex)
+  {
+    const int itkAxis = GetSpatialITKAxis(storeAxes[storeIndex].name);
+    if (itkAxis < 0 || static_cast<unsigned>(itkAxis) >= requestedRegion.GetImageDimension())
+    {
+      continue;
+    }
+
+    const tensorstore::Index chunkSize = chunkShape[storeIndex];
+    const tensorstore::Index begin = requestedRegion.GetIndex(itkAxis);
+    const tensorstore::Index end = begin + static_cast<tensorstore::Index>(requestedRegion.GetSize(itkAxis));
+    const tensorstore::Index alignedBegin = (begin / chunkSize) * chunkSize;
+    const tensorstore::Index alignedEnd =
+      std::min(((end + chunkSize - 1) / chunkSize) * chunkSize, storeShape[storeIndex]);
+
+    streamableRegion.SetIndex(itkAxis, alignedBegin);
+    streamableRegion.SetSize(itkAxis, std::max(alignedEnd, end) - alignedBegin);
+  }
+
+  if (this->GetDebug())
+  {
+    std::cout << "Aligned requested region " << requestedRegion << " to chunk grid as " << streamableRegion;
+  }
+  return streamableRegion;
+}
+
+std::ostream &
+operator<<(std::ostream & out, const OMEZarrNGFFImageIOEnums::DownsamplingMethod value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mean:
+        return "itk::OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mean";
+      case OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mode:
+        return "itk::OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mode";
+      case OMEZarrNGFFImageIOEnums::DownsamplingMethod::Stride:
+        return "itk::OMEZarrNGFFImageIOEnums::DownsamplingMethod::Stride";
+      default:
+        return "INVALID VALUE FOR itk::OMEZarrNGFFImageIOEnums::DownsamplingMethod";
+    }
+  }();
+}
+
+std::ostream &
+operator<<(std::ostream & out, const OMEZarrNGFFImageIOEnums::ReadStatistic value)
+{
+  const auto index = static_cast<size_t>(value);
+  if (index < readStatisticNames.size())
+  {
+    return out << "itk::OMEZarrNGFFImageIOEnums::ReadStatistic::" << readStatisticNames[index];
+  }
+  return out << "INVALID VALUE FOR itk::OMEZarrNGFFImageIOEnums::ReadStatistic";
+}
+
+std::ostream &
+operator<<(std::ostream & out, const OMEZarrNGFFImageIOEnums::WriteMode value)
+{
+  return out << [value] {
+    switch (value)
+    {
+      case OMEZarrNGFFImageIOEnums::WriteMode::Create:
+        return "itk::OMEZarrNGFFImageIOEnums::WriteMode::Create";
+      case OMEZarrNGFFImageIOEnums::WriteMode::RegionWrite:
+        return "itk::OMEZarrNGFFImageIOEnums::WriteMode::RegionWrite";
+      case OMEZarrNGFFImageIOEnums::WriteMode::Update:
+        return "itk::OMEZarrNGFFImageIOEnums::WriteMode::Update";
+      default:
+        return "INVALID VALUE FOR itk::OMEZarrNGFFImageIOEnums::WriteMode";
+    }
+  }();
 }
 
 } // end namespace itk
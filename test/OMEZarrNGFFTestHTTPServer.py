@@ -0,0 +1,225 @@
+#==========================================================================
+#
+#   Copyright NumFOCUS
+#
+#   Licensed under the Apache License, Version 2.0 (the "License");
+#   you may not use this file except in compliance with the License.
+#   You may obtain a copy of the License at
+#
+#          https://www.apache.org/licenses/LICENSE-2.0.txt
+#
+#   Unless required by applicable law or agreed to in writing, software
+#   distributed under the License is distributed on an "AS IS" BASIS,
+#   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#   See the License for the specific language governing permissions and
+#   limitations under the License.
+#
+#==========================================================================*/
+
+# Local HTTP server standing in for a remote OME-Zarr store in tests.
+#
+# Serves the files of a directory over HTTP/1.1 with keep-alive connections,
+# optionally adding a fixed latency to every request, limiting the bandwidth
+# of every response and disabling byte range requests.
+#
+#   serve  runs the server in the foreground.
+#   start  runs the server in a background process, waits until it accepts
+#          connections and records its process ID and base URL in files.
+#          Used as a CTest fixture setup.
+#
+# Port 0, the default, lets the system pick a free port, so that servers of
+# concurrently running tests do not collide. Tests read the base URL from the
+# file written by the server.
+#   stop   terminates the server recorded in a process ID file. Used as a
+#          CTest fixture cleanup.
+
+import argparse
+import functools
+import http.server
+import os
+import re
+import signal
+import socket
+import subprocess
+import sys
+import time
+
+LOCALHOST_BINDING = '127.0.0.1'
+STARTUP_TIMEOUT_SECONDS = 30
+BANDWIDTH_BLOCK_SIZE = 16 * 1024
+
+
+class ThrottledRequestHandler(http.server.SimpleHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def __init__(self, *args, latency=0.0, bandwidth=0, ranges=True, **kwargs):
+        self.latency = latency
+        self.bandwidth = bandwidth
+        self.ranges = ranges
+        super().__init__(*args, **kwargs)
+
+    def log_message(self, format, *args):
+        pass
+
+    def do_GET(self):
+        self.serve(send_body=True)
+
+    def do_HEAD(self):
+        self.serve(send_body=False)
+
+    def serve(self, send_body):
+        if self.latency > 0:
+            time.sleep(self.latency)
+
+        path = self.translate_path(self.path)
+        if not os.path.isfile(path):
+            self.send_error(404, 'File not found')
+            return
+        with open(path, 'rb') as f:
+            content = f.read()
+
+        start, end = 0, len(content)
+        status = 200
+        requested = self.headers.get('Range')
+        if self.ranges and requested is not None:
+            byte_range = parse_byte_range(requested, len(content))
+            if byte_range is None:
+                self.send_response(416)
+                self.send_header('Content-Range', f'bytes */{len(content)}')
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                return
+            start, end = byte_range
+            status = 206
+
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/octet-stream')
+        self.send_header('Content-Length', str(end - start))
+        if self.ranges:
+            self.send_header('Accept-Ranges', 'bytes')
+        if status == 206:
+            self.send_header('Content-Range', f'bytes {start}-{end - 1}/{len(content)}')
+        self.end_headers()
+        if send_body:
+            self.send_throttled(memoryview(content)[start:end])
+
+    def send_throttled(self, body):
+        if self.bandwidth <= 0:
+            self.wfile.write(body)
+            return
+        for offset in range(0, len(body), BANDWIDTH_BLOCK_SIZE):
+            block = body[offset:offset + BANDWIDTH_BLOCK_SIZE]
+            self.wfile.write(block)
+            time.sleep(len(block) / self.bandwidth)
+
+
+def parse_byte_range(header, size):
+    """Returns the [start, end) interval of a single "bytes=" range, or None if it is not satisfiable."""
+    match = re.fullmatch(r'bytes=(\d*)-(\d*)', header.strip())
+    if match is None or match.group(1) == match.group(2) == '':
+        return None
+    if match.group(1) == '':
+        # Suffix range, i.e. the last bytes of the file
+        start, end = max(0, size - int(match.group(2))), size
+    else:
+        start = int(match.group(1))
+        end = size if match.group(2) == '' else min(size, int(match.group(2)) + 1)
+    if start >= end:
+        return None
+    return start, end
+
+
+def serve(args):
+    handler = functools.partial(ThrottledRequestHandler,
+                                directory=args.directory,
+                                latency=args.latency / 1000.0,
+                                bandwidth=args.bandwidth,
+                                ranges=not args.no_range)
+    server = http.server.ThreadingHTTPServer((LOCALHOST_BINDING, args.port), handler)
+    server.daemon_threads = True
+    signal.signal(signal.SIGTERM, lambda signum, frame: sys.exit(0))
+    url = f'http://{LOCALHOST_BINDING}:{server.server_address[1]}'
+    if args.url_file:
+        # Written to a temporary file first, so that a reader never sees a partial URL
+        with open(args.url_file + '.tmp', 'w') as f:
+            f.write(url)
+        os.replace(args.url_file + '.tmp', args.url_file)
+    print(f'Serving {args.directory} on {url}', flush=True)
+    try:
+        server.serve_forever()
+    finally:
+        server.server_close()
+
+
+def start(args):
+    os.makedirs(args.directory, exist_ok=True)
+    if os.path.exists(args.url_file):
+        os.remove(args.url_file)
+    command = [sys.executable, os.path.abspath(__file__), 'serve',
+               '--port', str(args.port),
+               '--url-file', args.url_file,
+               '--directory', args.directory,
+               '--latency', str(args.latency),
+               '--bandwidth', str(args.bandwidth)]
+    if args.no_range:
+        command.append('--no-range')
+    process = subprocess.Popen(command,
+                               stdin=subprocess.DEVNULL,
+                               stdout=subprocess.DEVNULL,
+                               stderr=subprocess.DEVNULL,
+                               start_new_session=True)
+
+    deadline = time.monotonic() + STARTUP_TIMEOUT_SECONDS
+    url = None
+    while True:
+        if process.poll() is not None:
+            raise RuntimeError(f'HTTP test server exited with code {process.returncode}')
+        try:
+            if url is None:
+                with open(args.url_file) as f:
+                    url = f.read()
+            port = int(url.rsplit(':', 1)[1])
+            with socket.create_connection((LOCALHOST_BINDING, port), timeout=1):
+                break
+        except OSError:
+            if time.monotonic() > deadline:
+                process.kill()
+                raise RuntimeError(f'HTTP test server did not start within {STARTUP_TIMEOUT_SECONDS} seconds')
+            time.sleep(0.1)
+
+    with open(args.pid_file, 'w') as f:
+        f.write(str(process.pid))
+    print(f'Serving {args.directory} on {url} (process {process.pid})')
+
+
+def stop(args):
+    if not os.path.exists(args.pid_file):
+        print(f'No HTTP test server recorded in {args.pid_file}')
+        return
+    with open(args.pid_file) as f:
+        pid = int(f.read())
+    os.remove(args.pid_file)
+    try:
+        os.kill(pid, signal.SIGTERM)
+    except OSError:
+        print(f'HTTP test server process {pid} is not running')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Local HTTP server for OME-Zarr tests.')
+    parser.add_argument('command', choices=['serve', 'start', 'stop'])
+    parser.add_argument('--port', type=int, default=0, help='port to listen on, 0 picks a free port')
+    parser.add_argument('--directory', default=os.getcwd(), help='directory to serve')
+    parser.add_argument('--latency', type=float, default=0.0, help='milliseconds added to every request')
+    parser.add_argument('--bandwidth', type=int, default=0, help='bytes per second of every response, 0 is unlimited')
+    parser.add_argument('--no-range', action='store_true', help='ignore byte range requests')
+    parser.add_argument('--pid-file', default='OMEZarrNGFFTestHTTPServer.pid')
+    parser.add_argument('--url-file', default='OMEZarrNGFFTestHTTPServer.url',
+                        help='file to write the base URL of the server to')
+    args = parser.parse_args()
+
+    {'serve': serve, 'start': start, 'stop': stop}[args.command](args)
+
+
+if __name__ == '__main__':
+    main()
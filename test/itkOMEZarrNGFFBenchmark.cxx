@@ -0,0 +1,426 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIterator.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+#include "itkTimeProbe.h"
+#include "itkVectorImage.h"
+
+// Measures read and write throughput and latency on synthetic stores.
+// Results are written as JSON, with one entry per benchmark:
+//   { "name", "repetitions", "bytes_per_operation", "chunks_per_operation",
+//     "mean_seconds", "p50_seconds", "p99_seconds", "megabytes_per_second", "chunks_per_second" }
+namespace
+{
+using PixelType = uint16_t;
+
+struct BenchmarkResult
+{
+  std::string         name;
+  size_t              bytesPerOperation;
+  size_t              chunksPerOperation;
+  std::vector<double> seconds{};
+};
+
+double
+Percentile(std::vector<double> values, double fraction)
+{
+  std::sort(values.begin(), values.end());
+  const double position = fraction * (values.size() - 1);
+  const auto   lower = static_cast<size_t>(position);
+  const auto   upper = std::min(lower + 1, values.size() - 1);
+  return values[lower] + (position - lower) * (values[upper] - values[lower]);
+}
+
+void
+WriteResults(const std::vector<BenchmarkResult> & results, std::ostream & os)
+{
+  os << "{\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i)
+  {
+    const auto & result = results[i];
+    double       totalSeconds = 0.0;
+    for (const auto seconds : result.seconds)
+    {
+      totalSeconds += seconds;
+    }
+    const double operations = result.seconds.size();
+    const double safeTotal = std::max(totalSeconds, 1e-9);
+    os << (i > 0 ? "," : "") << "\n    {"
+       << "\"name\": \"" << result.name << "\", "
+       << "\"repetitions\": " << result.seconds.size() << ", "
+       << "\"bytes_per_operation\": " << result.bytesPerOperation << ", "
+       << "\"chunks_per_operation\": " << result.chunksPerOperation << ", "
+       << "\"mean_seconds\": " << totalSeconds / operations << ", "
+       << "\"p50_seconds\": " << Percentile(result.seconds, 0.5) << ", "
+       << "\"p99_seconds\": " << Percentile(result.seconds, 0.99) << ", "
+       << "\"megabytes_per_second\": " << operations * result.bytesPerOperation / (1024.0 * 1024.0) / safeTotal
+       << ", "
+       << "\"chunks_per_second\": " << operations * result.chunksPerOperation / safeTotal << "}";
+  }
+  os << "\n  ]\n}\n";
+}
+
+// Times `operation` once per repetition
+template <typename TOperation>
+BenchmarkResult
+Measure(const std::string & name,
+        unsigned            repetitions,
+        size_t              bytesPerOperation,
+        size_t              chunksPerOperation,
+        TOperation &&       operation)
+{
+  BenchmarkResult result{ name, bytesPerOperation, chunksPerOperation };
+  for (unsigned repetition = 0; repetition < repetitions; ++repetition)
+  {
+    itk::TimeProbe probe;
+    probe.Start();
+    operation(repetition);
+    probe.Stop();
+    result.seconds.push_back(probe.GetTotal());
+  }
+  std::cout << name << ": p50 " << Percentile(result.seconds, 0.5) << " s" << std::endl;
+  return result;
+}
+
+// Returns a synthetic image with `edge` voxels along spatial axes, 2 channels and 3 time points,
+// filled with smooth values plus noise so that compression ratios are realistic.
+template <unsigned VDimension>
+typename itk::Image<PixelType, VDimension>::Pointer
+MakeImage(itk::SizeValueType edge)
+{
+  using ImageType = itk::Image<PixelType, VDimension>;
+  typename ImageType::SizeType size;
+  for (unsigned d = 0; d < VDimension; ++d)
+  {
+    size[d] = (d < 3) ? edge : (d == 3 ? 2 : 3);
+  }
+  auto image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+
+  std::mt19937                            generator(42);
+  std::uniform_int_distribution<unsigned> noise(0, 15);
+  PixelType                               value = 0;
+  for (itk::ImageRegionIterator<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(static_cast<PixelType>(value++ / 8 + noise(generator)));
+  }
+  return image;
+}
+
+// Chunks span `chunkEdge` voxels along spatial axes and single channels and time points
+template <unsigned VDimension>
+itk::OMEZarrNGFFImageIO::ChunkShapeType
+MakeChunkShape(itk::SizeValueType chunkEdge)
+{
+  itk::OMEZarrNGFFImageIO::ChunkShapeType chunkShape(VDimension);
+  for (unsigned d = 0; d < VDimension; ++d)
+  {
+    chunkShape[d] = (d < 3) ? chunkEdge : 1;
+  }
+  return chunkShape;
+}
+
+template <typename TRegion>
+size_t
+CountChunks(const TRegion & region, const itk::OMEZarrNGFFImageIO::ChunkShapeType & chunkShape)
+{
+  size_t chunks = 1;
+  for (unsigned d = 0; d < TRegion::ImageDimension; ++d)
+  {
+    const auto                chunkSize = static_cast<itk::IndexValueType>(chunkShape[d]);
+    const itk::IndexValueType first = region.GetIndex(d) / chunkSize;
+    const itk::IndexValueType last =
+      (region.GetIndex(d) + static_cast<itk::IndexValueType>(region.GetSize(d)) - 1) / chunkSize;
+    chunks *= last - first + 1;
+  }
+  return chunks;
+}
+
+template <typename TImage>
+void
+WriteStore(const TImage *                                  image,
+           const std::string &                             fileName,
+           const itk::OMEZarrNGFFImageIO::ChunkShapeType & chunkShape,
+           const std::string &                             compressor,
+           unsigned                                        streamDivisions)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetChunkShape(chunkShape);
+  zarrIO->SetCompressor(compressor);
+  auto writer = itk::ImageFileWriter<TImage>::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->SetImageIO(zarrIO);
+  writer->SetNumberOfStreamDivisions(streamDivisions);
+  writer->Update();
+}
+
+// Reads the channels of a store into pixel components and its time points along an ITK axis,
+// so that every voxel is read rather than a single channel and time point
+template <typename TImage>
+void
+ReadStore(const std::string & fileName, const typename TImage::RegionType * region = nullptr)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->ChannelsAsComponentsOn();
+  zarrIO->TimeAsDimensionOn();
+  auto reader = itk::ImageFileReader<TImage>::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(zarrIO);
+  if (region)
+  {
+    reader->GetOutput()->SetRequestedRegion(*region);
+  }
+  reader->Update();
+}
+
+// Streamed writes and full reads of a store with the given dimension
+template <unsigned VDimension>
+void
+BenchmarkDimension(const std::string &            outputPrefix,
+                   itk::SizeValueType             edge,
+                   unsigned                       repetitions,
+                   std::vector<BenchmarkResult> & results)
+{
+  // The "c" axis of 4D and 5D stores is read into components of an image without that axis
+  using ReadImageType = std::conditional_t<(VDimension > 3),
+                                           itk::VectorImage<PixelType, (VDimension > 3 ? VDimension - 1 : VDimension)>,
+                                           itk::Image<PixelType, VDimension>>;
+  const auto        image = MakeImage<VDimension>(edge);
+  const auto        chunkShape = MakeChunkShape<VDimension>(std::max<itk::SizeValueType>(edge / 2, 1));
+  const auto        region = image->GetLargestPossibleRegion();
+  const size_t      bytes = region.GetNumberOfPixels() * sizeof(PixelType);
+  const size_t      chunks = CountChunks(region, chunkShape);
+  const std::string suffix = std::to_string(VDimension) + "d";
+  const std::string fileName = outputPrefix + "_" + suffix + ".zarr";
+
+  results.push_back(Measure("streamed_write_" + suffix, repetitions, bytes, chunks, [&](unsigned) {
+    WriteStore(image.GetPointer(), fileName, chunkShape, "", 4);
+  }));
+  results.push_back(Measure(
+    "full_read_" + suffix, repetitions, bytes, chunks, [&](unsigned) { ReadStore<ReadImageType>(fileName); }));
+}
+
+// Subregion, slice, compressor and zip benchmarks on a 3D store
+void
+Benchmark3D(const std::string &            outputPrefix,
+            itk::SizeValueType             edge,
+            unsigned                       repetitions,
+            std::vector<BenchmarkResult> & results)
+{
+  using ImageType = itk::Image<PixelType, 3>;
+  const auto        image = MakeImage<3>(edge);
+  const auto        chunkShape = MakeChunkShape<3>(std::max<itk::SizeValueType>(edge / 4, 1));
+  const auto        largestRegion = image->GetLargestPossibleRegion();
+  const size_t      bytes = largestRegion.GetNumberOfPixels() * sizeof(PixelType);
+  const size_t      chunks = CountChunks(largestRegion, chunkShape);
+  const std::string fileName = outputPrefix + "_3d_regions.zarr";
+  WriteStore(image.GetPointer(), fileName, chunkShape, "", 1);
+
+  // Random subregions of a quarter of the extent along each axis
+  std::mt19937                                       generator(7);
+  const itk::SizeValueType                           subregionEdge = std::max<itk::SizeValueType>(edge / 4, 1);
+  std::vector<ImageType::RegionType>                 subregions;
+  std::uniform_int_distribution<itk::IndexValueType> position(0, edge - subregionEdge);
+  for (unsigned repetition = 0; repetition < repetitions; ++repetition)
+  {
+    ImageType::RegionType subregion;
+    for (unsigned d = 0; d < 3; ++d)
+    {
+      subregion.SetIndex(d, position(generator));
+      subregion.SetSize(d, subregionEdge);
+    }
+    subregions.push_back(subregion);
+  }
+  results.push_back(Measure("random_subregion_read_3d",
+                            repetitions,
+                            subregions.front().GetNumberOfPixels() * sizeof(PixelType),
+                            CountChunks(subregions.front(), chunkShape),
+                            [&](unsigned repetition) { ReadStore<ImageType>(fileName, &subregions[repetition]); }));
+
+  // Single z slices
+  ImageType::RegionType slice(largestRegion);
+  slice.SetSize(2, 1);
+  results.push_back(Measure("slice_read_3d",
+                            repetitions,
+                            slice.GetNumberOfPixels() * sizeof(PixelType),
+                            CountChunks(slice, chunkShape),
+                            [&](unsigned repetition) {
+                              ImageType::RegionType zSlice(slice);
+                              zSlice.SetIndex(2, (repetition * 7) % edge);
+                              ReadStore<ImageType>(fileName, &zSlice);
+                            }));
+
+  // Each compressor
+  for (const std::string compressor : { "BLOSC_LZ4", "BLOSC_ZSTD", "BLOSC_BLOSCLZ", "ZSTD", "GZIP", "NONE" })
+  {
+    const std::string compressorFileName = outputPrefix + "_3d_" + compressor + ".zarr";
+    results.push_back(Measure("write_3d_" + compressor, repetitions, bytes, chunks, [&](unsigned) {
+      WriteStore(image.GetPointer(), compressorFileName, chunkShape, compressor, 1);
+    }));
+    results.push_back(Measure("read_3d_" + compressor, repetitions, bytes, chunks, [&](unsigned) {
+      ReadStore<ImageType>(compressorFileName);
+    }));
+  }
+
+  // Zip files and in-memory zip
+  const std::string zipFileName = outputPrefix + "_3d.zip";
+  results.push_back(Measure("zip_write_3d", repetitions, bytes, chunks, [&](unsigned) {
+    WriteStore(image.GetPointer(), zipFileName, chunkShape, "", 1);
+  }));
+  results.push_back(
+    Measure("zip_read_3d", repetitions, bytes, chunks, [&](unsigned) { ReadStore<ImageType>(zipFileName); }));
+
+  // Each write starts from an empty zip, consisting of its "end of central directory" record,
+  // and allocates a new buffer for the written zip
+  char emptyZip[22] = { 'P', 'K', 5, 6 };
+  itk::OMEZarrNGFFImageIO::BufferInfo bufferInfo{ emptyZip, sizeof(emptyZip) };
+  const std::string                   memoryFileName = itk::OMEZarrNGFFImageIO::MakeMemoryFileName(bufferInfo);
+  const auto                          releaseBuffer = [&bufferInfo, &emptyZip]() {
+    if (bufferInfo.pointer != emptyZip)
+    {
+      free(bufferInfo.pointer);
+    }
+    bufferInfo = { emptyZip, sizeof(emptyZip) };
+  };
+  results.push_back(Measure("memory_zip_write_3d", repetitions, bytes, chunks, [&](unsigned) {
+    releaseBuffer();
+    WriteStore(image.GetPointer(), memoryFileName, chunkShape, "", 1);
+  }));
+  results.push_back(Measure(
+    "memory_zip_read_3d", repetitions, bytes, chunks, [&](unsigned) { ReadStore<ImageType>(memoryFileName); }));
+  releaseBuffer();
+}
+
+// Opens and reads of a 3D store through the "http" kvstore driver. The store is written
+// to `servedDirectory`, which a local HTTP server exposes at the base URL recorded in `baseURLFileName`.
+void
+BenchmarkHTTP(const std::string &            servedDirectory,
+              const std::string &            baseURLFileName,
+              itk::SizeValueType             edge,
+              unsigned                       repetitions,
+              std::vector<BenchmarkResult> & results)
+{
+  std::ifstream baseURLFile(baseURLFileName);
+  std::string   baseURL;
+  if (!(baseURLFile >> baseURL))
+  {
+    itkGenericExceptionMacro(<< "Failed to read the base URL of the local HTTP server from " << baseURLFileName);
+  }
+
+  using ImageType = itk::Image<PixelType, 3>;
+  const auto        image = MakeImage<3>(edge);
+  const auto        chunkShape = MakeChunkShape<3>(std::max<itk::SizeValueType>(edge / 4, 1));
+  const auto        largestRegion = image->GetLargestPossibleRegion();
+  const size_t      bytes = largestRegion.GetNumberOfPixels() * sizeof(PixelType);
+  const size_t      chunks = CountChunks(largestRegion, chunkShape);
+  const std::string storeName = "benchmark_http.zarr";
+  const std::string url = baseURL + "/" + storeName;
+  WriteStore(image.GetPointer(), servedDirectory + "/" + storeName, chunkShape, "", 1);
+
+  results.push_back(Measure("http_open_3d", repetitions, 0, 0, [&](unsigned) {
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->SetFileName(url);
+    zarrIO->ReadImageInformation();
+  }));
+  results.push_back(
+    Measure("http_full_read_3d", repetitions, bytes, chunks, [&](unsigned) { ReadStore<ImageType>(url); }));
+
+  ImageType::RegionType subregion;
+  for (unsigned d = 0; d < 3; ++d)
+  {
+    subregion.SetIndex(d, edge / 4);
+    subregion.SetSize(d, std::max<itk::SizeValueType>(edge / 2, 1));
+  }
+  results.push_back(Measure("http_subregion_read_3d",
+                            repetitions,
+                            subregion.GetNumberOfPixels() * sizeof(PixelType),
+                            CountChunks(subregion, chunkShape),
+                            [&](unsigned) { ReadStore<ImageType>(url, &subregion); }));
+
+  ImageType::RegionType slice(largestRegion);
+  slice.SetSize(2, 1);
+  results.push_back(Measure("http_slice_read_3d",
+                            repetitions,
+                            slice.GetNumberOfPixels() * sizeof(PixelType),
+                            CountChunks(slice, chunkShape),
+                            [&](unsigned repetition) {
+                              ImageType::RegionType zSlice(slice);
+                              zSlice.SetIndex(2, (repetition * 7) % edge);
+                              ReadStore<ImageType>(url, &zSlice);
+                            }));
+}
+} // namespace
+
+int
+itkOMEZarrNGFFBenchmark(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv)
+              << " Results.json OutputPrefix [Edge] [Repetitions] [HTTPServedDirectory HTTPBaseURLFile]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const std::string        resultsFileName = argv[1];
+  const std::string        outputPrefix = argv[2];
+  const itk::SizeValueType edge = (argc > 3) ? std::stoul(argv[3]) : 128;
+  const unsigned           repetitions = (argc > 4) ? std::stoul(argv[4]) : 10;
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  std::vector<BenchmarkResult> results;
+  if (argc > 6)
+  {
+    // Only benchmark the network path, against a local HTTP server
+    ITK_TRY_EXPECT_NO_EXCEPTION(BenchmarkHTTP(argv[5], argv[6], edge, repetitions, results));
+  }
+  else
+  {
+    ITK_TRY_EXPECT_NO_EXCEPTION(BenchmarkDimension<2>(outputPrefix, edge, repetitions, results));
+    ITK_TRY_EXPECT_NO_EXCEPTION(BenchmarkDimension<3>(outputPrefix, edge, repetitions, results));
+    ITK_TRY_EXPECT_NO_EXCEPTION(BenchmarkDimension<4>(outputPrefix, edge, repetitions, results));
+    ITK_TRY_EXPECT_NO_EXCEPTION(BenchmarkDimension<5>(outputPrefix, edge, repetitions, results));
+    ITK_TRY_EXPECT_NO_EXCEPTION(Benchmark3D(outputPrefix, edge, repetitions, results));
+  }
+
+  std::ofstream resultsFile(resultsFileName);
+  WriteResults(results, resultsFile);
+  if (!resultsFile)
+  {
+    std::cerr << "Failed to write benchmark results to " << resultsFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMetaDataObject.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkStreamingImageFilter.h"
+#include "itkTestingMacros.h"
+#include "itkTestingComparisonImageFilter.h"
+
+namespace
+{
+// Returns the text of a JSON metadata file with whitespace removed, so that its fields can be matched as text
+std::string
+ReadCompactJson(const std::string & fileName)
+{
+  std::ifstream file(fileName);
+  std::string   json{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+  json.erase(std::remove_if(json.begin(), json.end(), [](unsigned char c) { return std::isspace(c); }), json.end());
+  return json;
+}
+
+// Whether the metadata file holds every field, reporting the missing ones
+bool
+HasFields(const std::string & fileName, const std::vector<std::string> & fields)
+{
+  const std::string json = ReadCompactJson(fileName);
+  bool              hasFields = !json.empty();
+  for (const auto & field : fields)
+  {
+    if (json.find(field) == std::string::npos)
+    {
+      std::cerr << "Missing " << field << " in " << fileName << ": " << json << std::endl;
+      hasFields = false;
+    }
+  }
+  return hasFields;
+}
+} // namespace
+
+int
+itkOMEZarrNGFFCompressionTest(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *      inputFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  using ImageType = itk::Image<unsigned char, 2>;
+  auto image = itk::ReadImage<ImageType>(inputFileName);
+
+  // The zarr v2 compressor written for each compressor name at level 9. Blosc bit-shuffles 1-byte components.
+  const std::vector<std::pair<std::string, std::vector<std::string>>> compressors = {
+    { "", { "\"id\":\"blosc\"", "\"cname\":\"lz4\"", "\"clevel\":9", "\"shuffle\":2" } },
+    { "BLOSC", { "\"id\":\"blosc\"", "\"cname\":\"lz4\"", "\"clevel\":9", "\"shuffle\":2" } },
+    { "BLOSC_LZ4", { "\"id\":\"blosc\"", "\"cname\":\"lz4\"", "\"clevel\":9", "\"shuffle\":2" } },
+    { "BLOSC_ZSTD", { "\"id\":\"blosc\"", "\"cname\":\"zstd\"", "\"clevel\":9", "\"shuffle\":2" } },
+    { "BLOSC_BLOSCLZ", { "\"id\":\"blosc\"", "\"cname\":\"blosclz\"", "\"clevel\":9", "\"shuffle\":2" } },
+    { "ZSTD", { "\"id\":\"zstd\"", "\"level\":9" } },
+    { "GZIP", { "\"id\":\"gzip\"", "\"level\":9" } },
+    { "NONE", { "\"compressor\":null" } },
+  };
+  for (const auto & [compressor, compressorFields] : compressors)
+  {
+    const std::string outputFileName = outputPrefix + "_" + (compressor.empty() ? "default" : compressor) + ".zarr";
+    std::cout << "Writing " << outputFileName << std::endl;
+
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->SetCompressor(compressor);
+    ITK_TEST_EXPECT_EQUAL(zarrIO->GetCompressor(), compressor);
+    zarrIO->SetCompressionLevel(9);
+
+    auto writer = itk::ImageFileWriter<ImageType>::New();
+    writer->SetInput(image);
+    writer->SetFileName(outputFileName);
+    writer->SetImageIO(zarrIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+    ITK_TEST_EXPECT_TRUE(HasFields(outputFileName + "/s0/.zarray", compressorFields));
+
+    // Validate the round trip is lossless for every codec
+    auto comparer = itk::Testing::ComparisonImageFilter<ImageType, ImageType>::New();
+    comparer->SetValidInput(image);
+    comparer->SetTestInput(itk::ReadImage<ImageType>(outputFileName));
+    comparer->Update();
+    if (comparer->GetNumberOfPixelsWithDifferences() > 0)
+    {
+      std::cerr << "Image written with compressor \"" << compressor << "\" differs from its input" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Zarr v3 arrays list the compressor as a codec following the "bytes" codec
+  const std::string zarr3FileName = outputPrefix + "_BLOSC_ZSTD.zr3";
+  auto              zarr3IO = itk::OMEZarrNGFFImageIO::New();
+  zarr3IO->SetCompressor("BLOSC_ZSTD");
+  zarr3IO->SetCompressionLevel(7);
+  auto zarr3Writer = itk::ImageFileWriter<ImageType>::New();
+  zarr3Writer->SetInput(image);
+  zarr3Writer->SetFileName(zarr3FileName);
+  zarr3Writer->SetImageIO(zarr3IO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(zarr3Writer->Update());
+  ITK_TEST_EXPECT_TRUE(HasFields(zarr3FileName + "/s0/zarr.json",
+                                 { "\"name\":\"bytes\"",
+                                   "\"name\":\"blosc\"",
+                                   "\"cname\":\"zstd\"",
+                                   "\"clevel\":7",
+                                   "\"shuffle\":\"bitshuffle\"",
+                                   "\"typesize\":1" }));
+
+  // Chunk-aligned reads of uncompressed zarr v2 and v3 chunks copy the stored bytes directly
+  const std::string uncompressedFileName = outputPrefix + "_NONE_chunked.zarr";
+  const std::string uncompressedZarr3FileName = outputPrefix + "_NONE_chunked.zr3";
+  for (const auto & fileName : { uncompressedFileName, uncompressedZarr3FileName })
+  {
+    auto writerIO = itk::OMEZarrNGFFImageIO::New();
+    writerIO->SetCompressor("NONE");
+    writerIO->SetChunkShape({ 64, 32 });
+    auto writer = itk::ImageFileWriter<ImageType>::New();
+    writer->SetInput(image);
+    writer->SetFileName(fileName);
+    writer->SetImageIO(writerIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  }
+
+  const ImageType::RegionType alignedRegion({ { 64, 32 } }, { { 128, 96 } });
+  for (const auto & [fileName, directChunkReading, memoryMappedReading] :
+       { std::tuple{ uncompressedFileName, true, false },
+         std::tuple{ uncompressedFileName, true, true },
+         std::tuple{ uncompressedFileName, false, false },
+         std::tuple{ uncompressedZarr3FileName, true, false },
+         std::tuple{ uncompressedZarr3FileName, true, true } })
+  {
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->SetDirectChunkReading(directChunkReading);
+    ITK_TEST_SET_GET_VALUE(directChunkReading, zarrIO->GetDirectChunkReading());
+    zarrIO->SetMemoryMappedReading(memoryMappedReading);
+    ITK_TEST_SET_GET_VALUE(memoryMappedReading, zarrIO->GetMemoryMappedReading());
+    ITK_TEST_SET_GET_BOOLEAN(zarrIO, CollectReadStatistics, true);
+    ITK_TEST_SET_GET_BOOLEAN(zarrIO, ReadStatisticsInMetaDataDictionary, true);
+    auto reader = itk::ImageFileReader<ImageType>::New();
+    reader->SetFileName(fileName);
+    reader->SetImageIO(zarrIO);
+    reader->GetOutput()->SetRequestedRegion(alignedRegion);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+    ITK_TEST_EXPECT_EQUAL(reader->GetOutput()->GetBufferedRegion(), alignedRegion);
+    for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, alignedRegion); !it.IsAtEnd(); ++it)
+    {
+      if (reader->GetOutput()->GetPixel(it.GetIndex()) != it.Get())
+      {
+        std::cerr << "Pixel value mismatch in " << fileName << " at index " << it.GetIndex()
+                  << " with direct chunk reading " << (directChunkReading ? "on" : "off")
+                  << " and memory mapped reading " << (memoryMappedReading ? "on" : "off") << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    // The aligned region covers 2 x 3 chunks of 64 x 32 bytes
+    using ReadStatisticEnum = itk::OMEZarrNGFFImageIO::ReadStatisticEnum;
+    ITK_TEST_EXPECT_EQUAL(zarrIO->GetLastReadStatistic(ReadStatisticEnum::ChunksRequested), 6.0);
+    ITK_TEST_EXPECT_EQUAL(zarrIO->GetCumulativeReadStatistic(ReadStatisticEnum::ChunksRequested), 6.0);
+    if (directChunkReading)
+    {
+      ITK_TEST_EXPECT_EQUAL(zarrIO->GetLastReadStatistic(ReadStatisticEnum::BytesDecoded), 6.0 * 64 * 32);
+    }
+    // Only reads of raw chunks spend time copying them
+    ITK_TEST_EXPECT_EQUAL(zarrIO->GetLastReadStatistic(ReadStatisticEnum::CopySeconds) > 0.0, directChunkReading);
+    ITK_TEST_EXPECT_TRUE(zarrIO->GetLastReadStatistic(ReadStatisticEnum::TotalSeconds) > 0.0);
+    double chunksRequested = 0.0;
+    ITK_TEST_EXPECT_TRUE(itk::ExposeMetaData<double>(
+      zarrIO->GetMetaDataDictionary(), "OMEZarrNGFF_LastRead_ChunksRequested", chunksRequested));
+    ITK_TEST_EXPECT_EQUAL(chunksRequested, 6.0);
+    zarrIO->ResetReadStatistics();
+    ITK_TEST_EXPECT_EQUAL(zarrIO->GetCumulativeReadStatistic(ReadStatisticEnum::ChunksRequested), 0.0);
+  }
+
+  // Streamed reads of memory mapped chunks advise the chunk files of the following regions
+  auto mappedIO = itk::OMEZarrNGFFImageIO::New();
+  mappedIO->MemoryMappedReadingOn();
+  mappedIO->ChunkAlignedStreamingOn();
+  mappedIO->SetReadAheadDepth(2);
+  auto mappedReader = itk::ImageFileReader<ImageType>::New();
+  mappedReader->SetFileName(uncompressedFileName);
+  mappedReader->SetImageIO(mappedIO);
+  auto streamer = itk::StreamingImageFilter<ImageType, ImageType>::New();
+  streamer->SetInput(mappedReader->GetOutput());
+  streamer->SetNumberOfStreamDivisions(4);
+  ITK_TRY_EXPECT_NO_EXCEPTION(streamer->Update());
+  auto comparer = itk::Testing::ComparisonImageFilter<ImageType, ImageType>::New();
+  comparer->SetValidInput(image);
+  comparer->SetTestInput(streamer->GetOutput());
+  comparer->Update();
+  if (comparer->GetNumberOfPixelsWithDifferences() > 0)
+  {
+    std::cerr << "Image streamed from memory mapped chunks differs from its input" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
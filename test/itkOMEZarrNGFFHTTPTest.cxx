@@ -18,6 +18,8 @@
 
 // Read an OME-Zarr image from a remote store.
 // Example data is available at https://github.com/ome/ome-ngff-prototypes
+// Test case 4 instead reads stores written to a directory served by a local HTTP server,
+// whose base URL is read from the file the server recorded it in at startup.
 
 #include <fstream>
 #include "itkImageFileReader.h"
@@ -26,6 +28,7 @@
 #include "itkOMEZarrNGFFImageIOFactory.h"
 #include "itkTestingMacros.h"
 #include "itkImageIOBase.h"
+#include "itkTestingComparisonImageFilter.h"
 
 namespace
 {
@@ -197,6 +200,92 @@ testTimeAndChannelSlice(const std::string & outputPrefix)
   return EXIT_SUCCESS;
 }
 
+template <typename TImage>
+bool
+imagesDiffer(const TImage * expected, const TImage * actual)
+{
+  auto comparer = itk::Testing::ComparisonImageFilter<TImage, TImage>::New();
+  comparer->SetValidInput(expected);
+  comparer->SetTestInput(actual);
+  comparer->Update();
+  return comparer->GetNumberOfPixelsWithDifferences() > 0;
+}
+
+bool
+testLocalServer(const std::string & outputPrefix,
+                const std::string & inputFileName,
+                const std::string & servedDirectory,
+                const std::string & baseURLFileName)
+{
+  std::ifstream baseURLFile(baseURLFileName);
+  std::string   baseURL;
+  if (!(baseURLFile >> baseURL))
+  {
+    std::cerr << "Failed to read the base URL of the local HTTP server from " << baseURLFileName << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Write zarr v2 and sharded zarr v3 stores, then read them back over HTTP.
+  // Sharded chunks are read with byte range requests.
+  using ImageType = itk::Image<unsigned char, 2>;
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+  auto image = itk::ReadImage<ImageType>(inputFileName);
+
+  for (const std::string storeName : { "local.ome.zarr", "local.ome.zr3" })
+  {
+    auto writerIO = itk::OMEZarrNGFFImageIO::New();
+    writerIO->SetChunkShape({ 64, 64 });
+    writerIO->SetNumberOfResolutionLevels(2);
+    if (storeName == "local.ome.zr3")
+    {
+      writerIO->SetShardShape({ 128, 128 });
+    }
+    auto writer = itk::ImageFileWriter<ImageType>::New();
+    writer->SetInput(image);
+    writer->SetFileName(servedDirectory + "/" + storeName);
+    writer->SetImageIO(writerIO);
+    writer->Update();
+
+    const std::string url = baseURL + "/" + storeName;
+    auto              remoteImage = itk::ReadImage<ImageType>(url);
+    ITK_TEST_EXPECT_EQUAL(remoteImage->GetLargestPossibleRegion(), image->GetLargestPossibleRegion());
+    if (imagesDiffer(image.GetPointer(), remoteImage.GetPointer()))
+    {
+      std::cerr << "Image read from " << url << " differs from the written image" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    // A subregion spanning several chunks
+    const ImageType::RegionType requestedRegion({ { 40, 70 } }, { { 100, 90 } });
+    auto                        subregionReader = itk::ImageFileReader<ImageType>::New();
+    subregionReader->SetFileName(url);
+    subregionReader->GetOutput()->SetRequestedRegion(requestedRegion);
+    subregionReader->Update();
+    ITK_TEST_EXPECT_EQUAL(subregionReader->GetOutput()->GetBufferedRegion(), requestedRegion);
+
+    // The lower resolution level
+    ImageType::Pointer levelImages[2];
+    for (const bool remote : { false, true })
+    {
+      auto imageIO = itk::OMEZarrNGFFImageIO::New();
+      imageIO->SetDatasetIndex(1);
+      auto reader = itk::ImageFileReader<ImageType>::New();
+      reader->SetFileName(remote ? url : servedDirectory + "/" + storeName);
+      reader->SetImageIO(imageIO);
+      reader->Update();
+      levelImages[remote] = reader->GetOutput();
+    }
+    if (imagesDiffer(levelImages[0].GetPointer(), levelImages[1].GetPointer()))
+    {
+      std::cerr << "Resolution level 1 read from " << url << " differs from the level read from disk" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  writeOutputImage(itk::ReadImage<ImageType>(baseURL + "/local.ome.zarr"), outputPrefix, 0);
+  return EXIT_SUCCESS;
+}
+
 } // namespace
 
 int
@@ -224,6 +313,14 @@ itkOMEZarrNGFFHTTPTest(int argc, char * argv[])
       return testTimeSlice(outputPrefix);
     case 3:
       return testTimeAndChannelSlice(outputPrefix);
+    case 4:
+      if (argc < 6)
+      {
+        std::cerr << "Usage: " << itkNameOfTestExecutableMacro(argv)
+                  << " 4 <outputPrefix> <input> <servedDirectory> <baseURLFile>" << std::endl;
+        return EXIT_FAILURE;
+      }
+      return testLocalServer(outputPrefix, argv[3], argv[4], argv[5]);
     default:
       throw std::invalid_argument("Invalid test case ID: " + std::to_string(testCase));
   }
@@ -105,9 +105,10 @@ doTest(const char * inputFileName, const char * outputFileName)
   writer->SetImageIO(zarrIO);
   ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
 
-  // Verify the output buffer occupies a new memory region with the expected size
+  // Verify the output buffer occupies a new memory region holding a zip archive
   // and that the BufferInfo object was updated in place to point to the new output buffer
-  ITK_TEST_EXPECT_EQUAL(bufferInfo.size, inputBufferSize);
+  ITK_TEST_EXPECT_TRUE(bufferInfo.size > 0);
+  ITK_TEST_EXPECT_TRUE(std::string(bufferInfo.pointer, 4) == "PK\x03\x04");
   ITK_TEST_EXPECT_TRUE(bufferInfo.pointer != inputBufferPointer);
   ITK_TEST_EXPECT_EQUAL(itk::OMEZarrNGFFImageIO::MakeMemoryFileName(bufferInfo), memAddress);
 
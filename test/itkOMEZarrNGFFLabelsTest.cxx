@@ -0,0 +1,195 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+using IntensityImageType = itk::Image<unsigned char, 3>;
+using LabelImageType = itk::Image<unsigned int, 3>;
+
+constexpr unsigned majorityLabel = 3;
+constexpr unsigned minorityLabel = 200;
+
+template <typename TImage>
+typename TImage::Pointer
+ReadImage(const char * fileName, const std::string & labelName, int datasetIndex)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetLabelName(labelName);
+  zarrIO->SetDatasetIndex(datasetIndex);
+  auto reader = itk::ImageFileReader<TImage>::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(zarrIO);
+  reader->Update();
+  return reader->GetOutput();
+}
+
+template <typename TImage>
+void
+WriteImage(const TImage * image, const char * fileName, const std::string & labelName, unsigned zarrFormat = 0)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetLabelName(labelName);
+  zarrIO->SetZarrFormat(zarrFormat);
+  zarrIO->SetNumberOfResolutionLevels(2);
+  auto writer = itk::ImageFileWriter<TImage>::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->SetImageIO(zarrIO);
+  writer->Update();
+}
+
+template <typename TImage>
+bool
+ImagesMatch(const TImage * expected, const TImage * actual)
+{
+  if (expected->GetLargestPossibleRegion() != actual->GetLargestPossibleRegion())
+  {
+    std::cerr << "Expected region " << expected->GetLargestPossibleRegion() << " but got "
+              << actual->GetLargestPossibleRegion() << std::endl;
+    return false;
+  }
+  itk::ImageRegionConstIterator<TImage> expectedIt(expected, expected->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<TImage> actualIt(actual, actual->GetLargestPossibleRegion());
+  for (; !expectedIt.IsAtEnd(); ++expectedIt, ++actualIt)
+  {
+    if (expectedIt.Get() != actualIt.Get())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+FileExists(const std::string & fileName)
+{
+  return std::ifstream(fileName).good();
+}
+} // namespace
+
+int
+itkOMEZarrNGFFLabelsTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Output [ZarrFormat]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *   outputFileName = argv[1];
+  const unsigned zarrFormat = argc > 2 ? std::stoi(argv[2]) : 0;
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  const IntensityImageType::SizeType size{ { 32, 24, 16 } };
+  auto                               image = IntensityImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<IntensityImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(static_cast<unsigned char>(index[0] + 3 * index[1] + 5 * index[2]));
+  }
+
+  // Five voxels of each 2x2x2 block hold one label and three hold another, so that Mode downsampling
+  // yields the majority label, whereas averaging would yield a value between the two labels
+  auto labels = LabelImageType::New();
+  labels->SetRegions(size);
+  labels->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<LabelImageType> it(labels, labels->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto &   index = it.GetIndex();
+    const auto     odd = index[0] % 2 + index[1] % 2 + index[2] % 2;
+    it.Set(odd <= 1 || (odd == 2 && index[2] % 2 == 0) ? majorityLabel : minorityLabel);
+  }
+
+  // Label images need an image to be written into
+  const std::string missingFileName = std::string(outputFileName) + "Missing.zarr";
+  ITK_TRY_EXPECT_EXCEPTION(WriteImage(labels.GetPointer(), missingFileName.c_str(), "cells"));
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteImage(image.GetPointer(), outputFileName, "", zarrFormat));
+
+  // Label images are written next to the image, and rewriting one keeps a single entry for it
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteImage(labels.GetPointer(), outputFileName, "cells"));
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteImage(labels.GetPointer(), outputFileName, "nuclei"));
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteImage(labels.GetPointer(), outputFileName, "cells"));
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetFileName(outputFileName);
+  const std::vector<std::string> expectedNames = { "cells", "nuclei" };
+  ITK_TEST_EXPECT_TRUE(zarrIO->GetLabelNames() == expectedNames);
+
+  // Label images take the zarr format of the image rather than that implied by its file name
+  const bool imageIsZarr3 = FileExists(std::string(outputFileName) + "/zarr.json");
+  ITK_TEST_EXPECT_EQUAL(FileExists(std::string(outputFileName) + "/labels/zarr.json"), imageIsZarr3);
+  ITK_TEST_EXPECT_EQUAL(FileExists(std::string(outputFileName) + "/labels/cells/zarr.json"), imageIsZarr3);
+
+  // A label image has no label images of its own
+  zarrIO->SetFileName(std::string(outputFileName) + "/labels/cells");
+  ITK_TEST_EXPECT_TRUE(zarrIO->GetLabelNames().empty());
+
+  IntensityImageType::Pointer readImage;
+  ITK_TRY_EXPECT_NO_EXCEPTION(readImage = ReadImage<IntensityImageType>(outputFileName, "", 0));
+  if (!ImagesMatch<IntensityImageType>(image, readImage))
+  {
+    std::cerr << "The image differs after writing its label images" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  LabelImageType::Pointer readLabels;
+  ITK_TRY_EXPECT_NO_EXCEPTION(readLabels = ReadImage<LabelImageType>(outputFileName, "nuclei", 0));
+  if (!ImagesMatch<LabelImageType>(labels, readLabels))
+  {
+    std::cerr << "The label image differs from the written one" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  LabelImageType::Pointer readLevel;
+  ITK_TRY_EXPECT_NO_EXCEPTION(readLevel = ReadImage<LabelImageType>(outputFileName, "cells", 1));
+  ITK_TEST_EXPECT_EQUAL(readLevel->GetLargestPossibleRegion().GetSize(), LabelImageType::SizeType({ { 16, 12, 8 } }));
+  for (itk::ImageRegionConstIterator<LabelImageType> it(readLevel, readLevel->GetLargestPossibleRegion());
+       !it.IsAtEnd();
+       ++it)
+  {
+    if (it.Get() != majorityLabel)
+    {
+      std::cerr << "Unexpected label " << it.Get() << " at resolution level 1" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Missing label images and label images in zip stores are rejected
+  ITK_TRY_EXPECT_EXCEPTION(ReadImage<LabelImageType>(outputFileName, "missing", 0));
+  const std::string zipFileName = std::string(outputFileName) + ".zip";
+  ITK_TRY_EXPECT_EXCEPTION(WriteImage(labels.GetPointer(), zipFileName.c_str(), "cells"));
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBinShrinkImageFilter.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+#include "itkTestingComparisonImageFilter.h"
+
+namespace
+{
+using ImageType = itk::Image<unsigned char, 2>;
+
+ImageType::Pointer
+readResolutionLevel(const std::string & fileName, int datasetIndex)
+{
+  auto imageIO = itk::OMEZarrNGFFImageIO::New();
+  imageIO->SetDatasetIndex(datasetIndex);
+  auto reader = itk::ImageFileReader<ImageType>::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(imageIO);
+  reader->Update();
+  return reader->GetOutput();
+}
+
+// Validates a resolution level against the mean of 2x2 blocks of the next higher resolution level.
+// Rounding of integer means may differ by one.
+void
+validateResolutionLevel(ImageType * higherLevel, ImageType * level)
+{
+  auto shrinker = itk::BinShrinkImageFilter<ImageType, ImageType>::New();
+  shrinker->SetInput(higherLevel);
+  shrinker->SetShrinkFactors(2);
+  shrinker->Update();
+  ITK_TEST_EXPECT_EQUAL(level->GetLargestPossibleRegion().GetSize(),
+                        shrinker->GetOutput()->GetLargestPossibleRegion().GetSize());
+
+  auto comparer = itk::Testing::ComparisonImageFilter<ImageType, ImageType>::New();
+  comparer->SetValidInput(shrinker->GetOutput());
+  comparer->SetTestInput(level);
+  comparer->SetDifferenceThreshold(1);
+  comparer->Update();
+  itkAssertOrThrowMacro(comparer->GetNumberOfPixelsWithDifferences() == 0,
+                        "Resolution level differs from the downsampled higher resolution level");
+}
+} // namespace
+
+int
+itkOMEZarrNGFFMultiscaleTest(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output.zarr" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *              inputFileName = argv[1];
+  const std::string         outputFileName = argv[2];
+  static constexpr unsigned NUMBER_OF_LEVELS = 3;
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  auto image = itk::ReadImage<ImageType>(inputFileName);
+
+  // Write all resolution levels in a single streamed pass
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetNumberOfResolutionLevels(NUMBER_OF_LEVELS);
+  ITK_TEST_SET_GET_VALUE(NUMBER_OF_LEVELS, zarrIO->GetNumberOfResolutionLevels());
+  zarrIO->SetDownsamplingMethod(itk::OMEZarrNGFFImageIOEnums::DownsamplingMethod::Mean);
+  zarrIO->SetChunkShape({ 32, 32 });
+
+  auto writer = itk::ImageFileWriter<ImageType>::New();
+  writer->SetInput(image);
+  writer->SetFileName(outputFileName);
+  writer->SetImageIO(zarrIO);
+  writer->SetNumberOfStreamDivisions(3);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  // Each level is downsampled from the chunks of the preceding level held in a cache pool
+  ITK_TEST_EXPECT_EQUAL(zarrIO->GetCachePoolSize(), 0u);
+  ITK_TEST_EXPECT_TRUE(zarrIO->GetTensorStoreContextSpec().find("\"cache_pool\"") != std::string::npos);
+
+  auto level0 = readResolutionLevel(outputFileName, 0);
+  auto level1 = readResolutionLevel(outputFileName, 1);
+  auto level2 = readResolutionLevel(outputFileName, 2);
+  level1->Print(std::cout);
+
+  ITK_TEST_EXPECT_EQUAL(level1->GetSpacing()[0], 2.0 * image->GetSpacing()[0]);
+  ITK_TEST_EXPECT_EQUAL(level2->GetSpacing()[1], 4.0 * image->GetSpacing()[1]);
+  validateResolutionLevel(level0, level1);
+  validateResolutionLevel(level1, level2);
+
+  // The geometry of every level can be queried once image information is read, which opens the arrays
+  // of other levels on first use. Neither querying nor switching levels opens an array twice.
+  auto levelIO = itk::OMEZarrNGFFImageIO::New();
+  levelIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(levelIO->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(levelIO->GetNumberOfDatasets(), NUMBER_OF_LEVELS);
+  const ImageType::Pointer levels[] = { level0, level1, level2 };
+  const auto &             constLevelIO = *levelIO; // the geometry of the levels is queried without side effects
+  for (unsigned datasetIndex = 0; datasetIndex < NUMBER_OF_LEVELS; ++datasetIndex)
+  {
+    const auto & level = levels[datasetIndex];
+    for (unsigned d = 0; d < ImageType::ImageDimension; ++d)
+    {
+      ITK_TEST_EXPECT_EQUAL(constLevelIO.GetDatasetDimensions(datasetIndex)[d],
+                            level->GetLargestPossibleRegion().GetSize(d));
+      ITK_TEST_EXPECT_EQUAL(constLevelIO.GetDatasetSpacing(datasetIndex)[d], level->GetSpacing()[d]);
+      ITK_TEST_EXPECT_EQUAL(constLevelIO.GetDatasetOrigin(datasetIndex)[d], level->GetOrigin()[d]);
+    }
+  }
+  ITK_TRY_EXPECT_EXCEPTION(constLevelIO.GetDatasetSpacing(NUMBER_OF_LEVELS));
+  ITK_TEST_EXPECT_EQUAL(levelIO->GetDimensions(0), level0->GetLargestPossibleRegion().GetSize(0));
+  for (const int datasetIndex : { 2, 0, 1 })
+  {
+    levelIO->SetDatasetIndex(datasetIndex);
+    ITK_TRY_EXPECT_NO_EXCEPTION(levelIO->ReadImageInformation());
+    ITK_TEST_EXPECT_EQUAL(levelIO->GetDimensions(0), levels[datasetIndex]->GetLargestPossibleRegion().GetSize(0));
+    ITK_TEST_EXPECT_EQUAL(levelIO->GetSpacing(1), levels[datasetIndex]->GetSpacing()[1]);
+  }
+  levelIO->SetDatasetIndex(NUMBER_OF_LEVELS);
+  ITK_TRY_EXPECT_EXCEPTION(levelIO->ReadImageInformation());
+
+  // Reading image information again notices that the store was rewritten with fewer levels
+  auto rewriteIO = itk::OMEZarrNGFFImageIO::New();
+  rewriteIO->SetNumberOfResolutionLevels(NUMBER_OF_LEVELS - 1);
+  writer->SetImageIO(rewriteIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  levelIO->SetDatasetIndex(0);
+  ITK_TRY_EXPECT_NO_EXCEPTION(levelIO->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(levelIO->GetNumberOfDatasets(), NUMBER_OF_LEVELS - 1);
+
+  // The levels read are discarded along with the file name they were read from
+  levelIO->SetFileName(outputFileName + ".other.zarr");
+  ITK_TEST_EXPECT_EQUAL(levelIO->GetNumberOfDatasets(), 0u);
+  ITK_TRY_EXPECT_EXCEPTION(levelIO->GetDatasetDimensions(0));
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
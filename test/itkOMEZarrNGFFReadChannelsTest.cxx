@@ -0,0 +1,117 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+#include "itkVectorImage.h"
+
+namespace
+{
+// Encodes the voxel position and its channel so that misplaced components are detected
+unsigned char
+ExpectedValue(const itk::Index<3> & index, itk::IndexValueType channel)
+{
+  return static_cast<unsigned char>((index[0] + 8 * index[1] + 48 * index[2] + 100 * channel) % 256);
+}
+} // namespace
+
+int
+itkOMEZarrNGFFReadChannelsTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char * outputFileName = argv[1];
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  // Write a 4D image whose last axis is stored as the channel "c" axis
+  constexpr itk::SizeValueType numberOfChannels = 3;
+  using ChannelImageType = itk::Image<unsigned char, 4>;
+  auto channelImage = ChannelImageType::New();
+  channelImage->SetRegions(ChannelImageType::SizeType{ { 8, 6, 4, numberOfChannels } });
+  channelImage->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ChannelImageType> it(channelImage, channelImage->GetBufferedRegion());
+       !it.IsAtEnd();
+       ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(ExpectedValue({ { index[0], index[1], index[2] } }, index[3]));
+  }
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::WriteImage(channelImage, outputFileName));
+
+  using VectorImageType = itk::VectorImage<unsigned char, 3>;
+  const std::vector<itk::OMEZarrNGFFImageIO::ChannelIndicesType> channelSelections = { {}, { 1, 2 }, { 2, 0 } };
+  for (const auto & channelIndices : channelSelections)
+  {
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->ChannelsAsComponentsOn();
+    zarrIO->SetChannelIndices(channelIndices);
+
+    auto reader = itk::ImageFileReader<VectorImageType>::New();
+    reader->SetFileName(outputFileName);
+    reader->SetImageIO(zarrIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+    VectorImageType::Pointer image = reader->GetOutput();
+
+    std::vector<itk::IndexValueType> expectedChannels(channelIndices.cbegin(), channelIndices.cend());
+    if (expectedChannels.empty())
+    {
+      for (itk::SizeValueType channel = 0; channel < numberOfChannels; ++channel)
+      {
+        expectedChannels.push_back(channel);
+      }
+    }
+    ITK_TEST_EXPECT_EQUAL(zarrIO->GetNumberOfDimensions(), 3u);
+    ITK_TEST_EXPECT_EQUAL(image->GetNumberOfComponentsPerPixel(), expectedChannels.size());
+    ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(), VectorImageType::SizeType({ { 8, 6, 4 } }));
+
+    for (itk::ImageRegionIteratorWithIndex<VectorImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+    {
+      const auto pixel = it.Get();
+      for (size_t component = 0; component < expectedChannels.size(); ++component)
+      {
+        if (pixel[component] != ExpectedValue(it.GetIndex(), expectedChannels[component]))
+        {
+          std::cerr << "Unexpected value " << static_cast<int>(pixel[component]) << " at index " << it.GetIndex()
+                    << " in component " << component << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  // Channel indices are validated against the store
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->ChannelsAsComponentsOn();
+  zarrIO->SetChannelIndices({ 0, numberOfChannels });
+  zarrIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_EXCEPTION(zarrIO->ReadImageInformation());
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <algorithm>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIndexRange.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+using PixelType = unsigned int;
+using ImageType = itk::Image<PixelType, 3>;
+
+// Encodes the voxel position and its channel so that misplaced values are detected
+PixelType
+ExpectedValue(const ImageType::IndexType & index, itk::IndexValueType channel)
+{
+  return static_cast<PixelType>(index[0] + 40 * index[1] + 1200 * index[2] + 30000 * channel);
+}
+
+itk::ImageIORegion
+MakeIORegion(const ImageType::RegionType & region)
+{
+  itk::ImageIORegion ioRegion(ImageType::ImageDimension);
+  for (unsigned d = 0; d < ImageType::ImageDimension; ++d)
+  {
+    ioRegion.SetIndex(d, region.GetIndex(d));
+    ioRegion.SetSize(d, region.GetSize(d));
+  }
+  return ioRegion;
+}
+} // namespace
+
+int
+itkOMEZarrNGFFReadRegionsTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char * outputFileName = argv[1];
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  // Write a chunked, multiscale 4D image whose last axis is stored as the channel "c" axis
+  constexpr itk::SizeValueType numberOfChannels = 3;
+  using ChannelImageType = itk::Image<PixelType, 4>;
+  auto channelImage = ChannelImageType::New();
+  channelImage->SetRegions(ChannelImageType::SizeType{ { 40, 30, 20, numberOfChannels } });
+  channelImage->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ChannelImageType> it(channelImage, channelImage->GetBufferedRegion());
+       !it.IsAtEnd();
+       ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(ExpectedValue({ { index[0], index[1], index[2] } }, index[3]));
+  }
+  auto writerIO = itk::OMEZarrNGFFImageIO::New();
+  writerIO->SetChunkShape({ 16, 16, 8, 1 });
+  writerIO->SetNumberOfResolutionLevels(2);
+  auto writer = itk::ImageFileWriter<ChannelImageType>::New();
+  writer->SetInput(channelImage);
+  writer->SetFileName(outputFileName);
+  writer->SetImageIO(writerIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetChannelIndex(0);
+  zarrIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(zarrIO->ReadImageInformation());
+  ITK_TEST_EXPECT_EQUAL(zarrIO->GetNumberOfDimensions(), 3);
+
+  // Overlapping crops sharing chunks, from several channels
+  const std::vector<ImageType::RegionType>     regions = { ImageType::RegionType({ { 0, 0, 0 } }, { { 20, 20, 10 } }),
+                                                           ImageType::RegionType({ { 10, 5, 4 } }, { { 20, 20, 10 } }),
+                                                           ImageType::RegionType({ { 10, 5, 4 } }, { { 20, 20, 10 } }),
+                                                           ImageType::RegionType({ { 33, 29, 19 } }, { { 7, 1, 1 } }) };
+  const std::vector<int>                      channels = { itk::OMEZarrNGFFImageIO::INVALID_INDEX, 0, 2, 1 };
+  std::vector<std::vector<PixelType>>         buffers(regions.size());
+  itk::OMEZarrNGFFImageIO::RegionReadListType regionReads;
+  for (size_t i = 0; i < regions.size(); ++i)
+  {
+    buffers[i].resize(regions[i].GetNumberOfPixels());
+    itk::OMEZarrNGFFImageIO::RegionRead regionRead;
+    regionRead.region = MakeIORegion(regions[i]);
+    regionRead.buffer = buffers[i].data();
+    regionRead.channelIndex = channels[i];
+    regionReads.push_back(regionRead);
+  }
+
+  // A crop of the lower resolution level
+  const ImageType::RegionType         levelRegion({ { 3, 2, 1 } }, { { 12, 9, 6 } });
+  std::vector<PixelType>              levelBuffer(levelRegion.GetNumberOfPixels());
+  itk::OMEZarrNGFFImageIO::RegionRead levelRead;
+  levelRead.region = MakeIORegion(levelRegion);
+  levelRead.buffer = levelBuffer.data();
+  levelRead.channelIndex = 1;
+  levelRead.datasetIndex = 1;
+  regionReads.push_back(levelRead);
+
+  ITK_TRY_EXPECT_NO_EXCEPTION(zarrIO->ReadRegions(regionReads));
+
+  for (size_t i = 0; i < regions.size(); ++i)
+  {
+    const itk::IndexValueType channel = std::max(channels[i], 0);
+    size_t                    offset = 0;
+    for (const auto & index : itk::ImageRegionIndexRange<3>(regions[i]))
+    {
+      if (buffers[i][offset++] != ExpectedValue(index, channel))
+      {
+        std::cerr << "Region " << i << " has an unexpected value at index " << index << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // The lower resolution level matches a read of the level through the reader
+  auto levelIO = itk::OMEZarrNGFFImageIO::New();
+  levelIO->SetChannelIndex(1);
+  levelIO->SetDatasetIndex(1);
+  auto reader = itk::ImageFileReader<ImageType>::New();
+  reader->SetFileName(outputFileName);
+  reader->SetImageIO(levelIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  size_t offset = 0;
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(reader->GetOutput(), levelRegion); !it.IsAtEnd(); ++it)
+  {
+    if (levelBuffer[offset++] != it.Get())
+    {
+      std::cerr << "Resolution level 1 has an unexpected value at index " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Channels read into pixel components, with a selection which is not a contiguous run
+  auto vectorIO = itk::OMEZarrNGFFImageIO::New();
+  vectorIO->ChannelsAsComponentsOn();
+  vectorIO->SetChannelIndices({ 2, 0 });
+  vectorIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(vectorIO->ReadImageInformation());
+  const ImageType::RegionType         vectorRegion({ { 12, 14, 6 } }, { { 9, 5, 4 } });
+  std::vector<PixelType>              vectorBuffer(vectorRegion.GetNumberOfPixels() * 2);
+  itk::OMEZarrNGFFImageIO::RegionRead vectorRead;
+  vectorRead.region = MakeIORegion(vectorRegion);
+  vectorRead.buffer = vectorBuffer.data();
+  ITK_TRY_EXPECT_NO_EXCEPTION(vectorIO->ReadRegions({ vectorRead }));
+  offset = 0;
+  for (const auto & index : itk::ImageRegionIndexRange<3>(vectorRegion))
+  {
+    for (const itk::IndexValueType channel : { 2, 0 })
+    {
+      if (vectorBuffer[offset++] != ExpectedValue(index, channel))
+      {
+        std::cerr << "Channel " << channel << " has an unexpected value at index " << index << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Regions exceeding the array are rejected
+  itk::OMEZarrNGFFImageIO::RegionRead outsideRead;
+  outsideRead.region = MakeIORegion(ImageType::RegionType({ { 30, 0, 0 } }, { { 20, 1, 1 } }));
+  outsideRead.buffer = buffers.front().data();
+  ITK_TRY_EXPECT_EXCEPTION(zarrIO->ReadRegions({ outsideRead }));
+
+  // and so are regions of another dimension than the image information
+  itk::OMEZarrNGFFImageIO::RegionRead flatRead;
+  flatRead.region = itk::ImageIORegion(2);
+  flatRead.region.SetSize(0, 4);
+  flatRead.region.SetSize(1, 4);
+  flatRead.buffer = buffers.front().data();
+  ITK_TRY_EXPECT_EXCEPTION(zarrIO->ReadRegions({ flatRead }));
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
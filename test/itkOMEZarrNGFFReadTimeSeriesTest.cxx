@@ -0,0 +1,132 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+#include "itkVectorImage.h"
+
+namespace
+{
+// Encodes the voxel position, channel and time point so that misplaced values are detected
+unsigned char
+ExpectedValue(const itk::Index<3> & index, itk::IndexValueType channel, itk::IndexValueType timePoint)
+{
+  return static_cast<unsigned char>((index[0] + 6 * index[1] + 30 * index[2] + 120 * channel + 17 * timePoint) % 256);
+}
+} // namespace
+
+int
+itkOMEZarrNGFFReadTimeSeriesTest(int argc, char * argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Output" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char * outputFileName = argv[1];
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  // Write a 5D image stored with "t,c,z,y,x" axes
+  using SeriesImageType = itk::Image<unsigned char, 5>;
+  auto series = SeriesImageType::New();
+  series->SetRegions(SeriesImageType::SizeType{ { 6, 5, 4, 2, 7 } });
+  series->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<SeriesImageType> it(series, series->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(ExpectedValue({ { index[0], index[1], index[2] } }, index[3], index[4]));
+  }
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::WriteImage(series, outputFileName));
+
+  // Read a window of time points from a single channel
+  {
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->TimeAsDimensionOn();
+    zarrIO->SetTimeIndex(2);
+    zarrIO->SetNumberOfTimePoints(3);
+    zarrIO->SetChannelIndex(1);
+
+    using ImageType = itk::Image<unsigned char, 4>;
+    auto reader = itk::ImageFileReader<ImageType>::New();
+    reader->SetFileName(outputFileName);
+    reader->SetImageIO(zarrIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+    ImageType::Pointer image = reader->GetOutput();
+
+    ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(), ImageType::SizeType({ { 6, 5, 4, 3 } }));
+    ITK_TEST_EXPECT_TRUE(itk::Math::FloatAlmostEqual(image->GetOrigin()[3], 2.0 * image->GetSpacing()[3]));
+    for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+    {
+      const auto & index = it.GetIndex();
+      if (it.Get() != ExpectedValue({ { index[0], index[1], index[2] } }, 1, 2 + index[3]))
+      {
+        std::cerr << "Unexpected value " << static_cast<int>(it.Get()) << " at index " << index << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  // Read every time point and channel at once
+  {
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->TimeAsDimensionOn();
+    zarrIO->ChannelsAsComponentsOn();
+
+    using VectorImageType = itk::VectorImage<unsigned char, 4>;
+    auto reader = itk::ImageFileReader<VectorImageType>::New();
+    reader->SetFileName(outputFileName);
+    reader->SetImageIO(zarrIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+    VectorImageType::Pointer image = reader->GetOutput();
+
+    ITK_TEST_EXPECT_EQUAL(image->GetLargestPossibleRegion().GetSize(), VectorImageType::SizeType({ { 6, 5, 4, 7 } }));
+    ITK_TEST_EXPECT_EQUAL(image->GetNumberOfComponentsPerPixel(), 2u);
+    for (itk::ImageRegionIteratorWithIndex<VectorImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+    {
+      const auto & index = it.GetIndex();
+      const auto   pixel = it.Get();
+      for (unsigned channel = 0; channel < 2; ++channel)
+      {
+        if (pixel[channel] != ExpectedValue({ { index[0], index[1], index[2] } }, channel, index[3]))
+        {
+          std::cerr << "Unexpected value " << static_cast<int>(pixel[channel]) << " at index " << index
+                    << " in channel " << channel << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+
+  // The time window is validated against the store
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->TimeAsDimensionOn();
+  zarrIO->SetTimeIndex(5);
+  zarrIO->SetNumberOfTimePoints(3);
+  zarrIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_EXCEPTION(zarrIO->ReadImageInformation());
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,356 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+using PixelType = unsigned short;
+using ImageType = itk::Image<PixelType, 3>;
+using WriteModeEnum = itk::OMEZarrNGFFImageIO::WriteModeEnum;
+
+itk::ImageIORegion
+MakeIORegion(const ImageType::RegionType & region)
+{
+  itk::ImageIORegion ioRegion(ImageType::ImageDimension);
+  for (unsigned d = 0; d < ImageType::ImageDimension; ++d)
+  {
+    ioRegion.SetIndex(d, region.GetIndex(d));
+    ioRegion.SetSize(d, region.GetSize(d));
+  }
+  return ioRegion;
+}
+
+// Sets up an image IO to write a region of the image into the existing store, as a separate writer would
+itk::OMEZarrNGFFImageIO::Pointer
+MakeRegionWriteIO(const ImageType *             image,
+                  const char *                  fileName,
+                  const ImageType::RegionType & region,
+                  const WriteModeEnum           writeMode = WriteModeEnum::RegionWrite)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetWriteMode(writeMode);
+  zarrIO->SetNumberOfResolutionLevels(2);
+  zarrIO->SetFileName(fileName);
+  zarrIO->SetNumberOfDimensions(ImageType::ImageDimension);
+  for (unsigned d = 0; d < ImageType::ImageDimension; ++d)
+  {
+    zarrIO->SetDimensions(d, image->GetLargestPossibleRegion().GetSize(d));
+  }
+  zarrIO->SetComponentType(itk::IOComponentEnum::USHORT);
+  zarrIO->SetIORegion(MakeIORegion(region));
+  return zarrIO;
+}
+
+// Returns the pixels of a region of the image, in buffer order
+std::vector<PixelType>
+CopyRegion(const ImageType * image, const ImageType::RegionType & region)
+{
+  std::vector<PixelType> buffer;
+  buffer.reserve(region.GetNumberOfPixels());
+  for (itk::ImageRegionConstIterator<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    buffer.push_back(it.Get());
+  }
+  return buffer;
+}
+
+bool
+ImagesMatch(const ImageType * expected, const ImageType * actual)
+{
+  if (expected->GetLargestPossibleRegion() != actual->GetLargestPossibleRegion())
+  {
+    std::cerr << "Expected region " << expected->GetLargestPossibleRegion() << " but got "
+              << actual->GetLargestPossibleRegion() << std::endl;
+    return false;
+  }
+  itk::ImageRegionConstIterator<ImageType> expectedIt(expected, expected->GetLargestPossibleRegion());
+  itk::ImageRegionConstIterator<ImageType> actualIt(actual, actual->GetLargestPossibleRegion());
+  for (; !expectedIt.IsAtEnd(); ++expectedIt, ++actualIt)
+  {
+    if (expectedIt.Get() != actualIt.Get())
+    {
+      std::cerr << "Unexpected value at index " << expectedIt.GetIndex() << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the image downsampled by striding along x and y only, as some tools build their pyramids
+ImageType::Pointer
+HalveXY(const ImageType * image)
+{
+  const auto & size = image->GetLargestPossibleRegion().GetSize();
+  auto         halved = ImageType::New();
+  halved->SetRegions(ImageType::SizeType{ { (size[0] + 1) / 2, (size[1] + 1) / 2, size[2] } });
+  halved->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(halved, halved->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(image->GetPixel({ { 2 * index[0], 2 * index[1], index[2] } }));
+  }
+  return halved;
+}
+
+// Writes the image as the single resolution level at the dataset index of the store
+void
+WriteLevel(const ImageType * image, const std::string & fileName, int datasetIndex, unsigned zarrFormat)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetChunkShape({ 16, 16, 8 });
+  zarrIO->SetZarrFormat(zarrFormat);
+  zarrIO->SetDatasetIndex(datasetIndex);
+  auto writer = itk::ImageFileWriter<ImageType>::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->SetImageIO(zarrIO);
+  writer->Update();
+}
+
+ImageType::Pointer
+ReadLevel(const char * fileName, int datasetIndex)
+{
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  zarrIO->SetDatasetIndex(datasetIndex);
+  auto reader = itk::ImageFileReader<ImageType>::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(zarrIO);
+  reader->Update();
+  return reader->GetOutput();
+}
+} // namespace
+
+int
+itkOMEZarrNGFFRegionWriteTest(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Output ReferenceOutput [ZarrFormat]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *   outputFileName = argv[1];
+  const char *   referenceFileName = argv[2];
+  const unsigned zarrFormat = argc > 3 ? std::stoi(argv[3]) : 0;
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 64, 48, 20 } });
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(static_cast<PixelType>(index[0] + 64 * index[1] + 7 * index[2]));
+  }
+
+  // The reference is written in a single pass
+  auto referenceIO = itk::OMEZarrNGFFImageIO::New();
+  referenceIO->SetChunkShape({ 16, 16, 8 });
+  referenceIO->SetZarrFormat(zarrFormat);
+  referenceIO->SetNumberOfResolutionLevels(2);
+  auto writer = itk::ImageFileWriter<ImageType>::New();
+  writer->SetInput(image);
+  writer->SetFileName(referenceFileName);
+  writer->SetImageIO(referenceIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+
+  // Create the store once, without any data. Region writers detect its format rather than taking it from the
+  // file name.
+  auto createIO = itk::OMEZarrNGFFImageIO::New();
+  createIO->SetChunkShape({ 16, 16, 8 });
+  createIO->SetZarrFormat(zarrFormat);
+  createIO->SetNumberOfResolutionLevels(2);
+  createIO->SetFileName(outputFileName);
+  createIO->SetNumberOfDimensions(ImageType::ImageDimension);
+  for (unsigned d = 0; d < ImageType::ImageDimension; ++d)
+  {
+    createIO->SetDimensions(d, image->GetLargestPossibleRegion().GetSize(d));
+  }
+  createIO->SetComponentType(itk::IOComponentEnum::USHORT);
+  ITK_TRY_EXPECT_NO_EXCEPTION(createIO->WriteImageInformation());
+
+  // Quadrants covering whole chunks of both levels are written from separate threads.
+  // The quadrants at the far end of the y axis are only partially covered by chunks.
+  const std::vector<ImageType::RegionType> quadrants = { ImageType::RegionType({ { 0, 0, 0 } }, { { 32, 32, 20 } }),
+                                                         ImageType::RegionType({ { 32, 0, 0 } }, { { 32, 32, 20 } }),
+                                                         ImageType::RegionType({ { 0, 32, 0 } }, { { 32, 16, 20 } }),
+                                                         ImageType::RegionType({ { 32, 32, 0 } }, { { 32, 16, 20 } }) };
+  std::atomic<int>                         failures{ 0 };
+  std::vector<std::thread>                 threads;
+  for (const auto & quadrant : quadrants)
+  {
+    threads.emplace_back([&, quadrant] {
+      try
+      {
+        auto zarrIO = MakeRegionWriteIO(image, outputFileName, quadrant);
+        zarrIO->Write(CopyRegion(image, quadrant).data());
+      }
+      catch (const itk::ExceptionObject & exception)
+      {
+        std::cerr << "Writing region " << quadrant << " failed: " << exception << std::endl;
+        ++failures;
+      }
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+  ITK_TEST_EXPECT_EQUAL(failures.load(), 0);
+
+  for (const int datasetIndex : { 0, 1 })
+  {
+    ImageType::Pointer expected;
+    ImageType::Pointer actual;
+    ITK_TRY_EXPECT_NO_EXCEPTION(expected = ReadLevel(referenceFileName, datasetIndex));
+    ITK_TRY_EXPECT_NO_EXCEPTION(actual = ReadLevel(outputFileName, datasetIndex));
+    if (!ImagesMatch(expected, actual))
+    {
+      std::cerr << "Resolution level " << datasetIndex << " differs from the reference" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Regions which share chunks with other regions are rejected, at the full resolution level
+  const ImageType::RegionType misaligned({ { 8, 0, 0 } }, { { 16, 16, 8 } });
+  auto                        misalignedIO = MakeRegionWriteIO(image, outputFileName, misaligned);
+  ITK_TRY_EXPECT_EXCEPTION(misalignedIO->Write(CopyRegion(image, misaligned).data()));
+
+  // and at the lower resolution level, where 16 voxels only fill half of a chunk
+  const ImageType::RegionType halfChunk({ { 16, 0, 0 } }, { { 16, 16, 8 } });
+  auto                        halfChunkIO = MakeRegionWriteIO(image, outputFileName, halfChunk);
+  ITK_TRY_EXPECT_EXCEPTION(halfChunkIO->Write(CopyRegion(image, halfChunk).data()));
+
+  // as are writers requesting another zarr format than the one of the store
+  const ImageType::RegionType firstQuadrant = quadrants.front();
+  auto                        otherFormatIO = MakeRegionWriteIO(image, outputFileName, firstQuadrant);
+  otherFormatIO->SetZarrFormat(zarrFormat == 3 ? 2 : 3);
+  ITK_TRY_EXPECT_EXCEPTION(otherFormatIO->Write(CopyRegion(image, firstQuadrant).data()));
+
+  // The rejected writes left the store unchanged
+  ImageType::Pointer level0;
+  ITK_TRY_EXPECT_NO_EXCEPTION(level0 = ReadLevel(outputFileName, 0));
+  if (!ImagesMatch(image, level0))
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Update mode rewrites a patch which covers chunks partially, and the lower resolution level
+  // matches the patched image written from scratch
+  const ImageType::RegionType patch({ { 5, 7, 3 } }, { { 30, 9, 6 } });
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, patch); !it.IsAtEnd(); ++it)
+  {
+    it.Set(9999);
+  }
+  auto updateIO = MakeRegionWriteIO(image, outputFileName, patch, WriteModeEnum::Update);
+  ITK_TEST_EXPECT_EQUAL(updateIO->GetWriteMode(), WriteModeEnum::Update);
+  ITK_TRY_EXPECT_NO_EXCEPTION(updateIO->Write(CopyRegion(image, patch).data()));
+  image->Modified();
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  for (const int datasetIndex : { 0, 1 })
+  {
+    ImageType::Pointer expected;
+    ImageType::Pointer actual;
+    ITK_TRY_EXPECT_NO_EXCEPTION(expected = ReadLevel(referenceFileName, datasetIndex));
+    ITK_TRY_EXPECT_NO_EXCEPTION(actual = ReadLevel(outputFileName, datasetIndex));
+    if (!ImagesMatch(expected, actual))
+    {
+      std::cerr << "Resolution level " << datasetIndex << " differs from the patched reference" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // A patch written to the full resolution level only, then propagated to the lower resolution level
+  const ImageType::RegionType edit({ { 40, 20, 9 } }, { { 11, 13, 5 } });
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, edit); !it.IsAtEnd(); ++it)
+  {
+    it.Set(123);
+  }
+  auto editIO = MakeRegionWriteIO(image, outputFileName, edit, WriteModeEnum::Update);
+  editIO->SetNumberOfResolutionLevels(1);
+  ITK_TRY_EXPECT_NO_EXCEPTION(editIO->Write(CopyRegion(image, edit).data()));
+  auto levelsIO = itk::OMEZarrNGFFImageIO::New();
+  levelsIO->SetFileName(outputFileName);
+  ITK_TRY_EXPECT_EXCEPTION(levelsIO->UpdateResolutionLevels(MakeIORegion(edit)));
+  ITK_TRY_EXPECT_NO_EXCEPTION(levelsIO->ReadImageInformation());
+  ITK_TRY_EXPECT_NO_EXCEPTION(levelsIO->UpdateResolutionLevels(MakeIORegion(edit)));
+  image->Modified();
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  for (const int datasetIndex : { 0, 1 })
+  {
+    ImageType::Pointer expected;
+    ImageType::Pointer actual;
+    ITK_TRY_EXPECT_NO_EXCEPTION(expected = ReadLevel(referenceFileName, datasetIndex));
+    ITK_TRY_EXPECT_NO_EXCEPTION(actual = ReadLevel(outputFileName, datasetIndex));
+    if (!ImagesMatch(expected, actual))
+    {
+      std::cerr << "Resolution level " << datasetIndex << " differs from the edited reference" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Pyramids written by other tools may keep the z axis and halve x and y only. Region and update writes take
+  // the factors between the levels from their array shapes, so they write the matching blocks of level 1.
+  // The levels are written separately, and the group lists the level written last as its only dataset.
+  const std::string xyFileName = std::string(outputFileName) + "XY.zarr";
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteLevel(image, xyFileName, 0, zarrFormat));
+  ITK_TRY_EXPECT_NO_EXCEPTION(WriteLevel(HalveXY(image), xyFileName, 1, zarrFormat));
+
+  // A region of half a z chunk covers whole chunks of level 1, as z is not downsampled
+  const ImageType::RegionType zSlab({ { 0, 0, 8 } }, { { 32, 32, 8 } });
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, zSlab); !it.IsAtEnd(); ++it)
+  {
+    it.Set(static_cast<PixelType>(it.Get() + 1000));
+  }
+  auto zSlabIO = MakeRegionWriteIO(image, xyFileName.c_str(), zSlab);
+  zSlabIO->SetDownsamplingMethod(itk::OMEZarrNGFFImageIO::DownsamplingMethodEnum::Stride);
+  ITK_TRY_EXPECT_NO_EXCEPTION(zSlabIO->Write(CopyRegion(image, zSlab).data()));
+
+  const ImageType::RegionType xyPatch({ { 3, 5, 2 } }, { { 20, 11, 7 } });
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, xyPatch); !it.IsAtEnd(); ++it)
+  {
+    it.Set(4321);
+  }
+  auto xyPatchIO = MakeRegionWriteIO(image, xyFileName.c_str(), xyPatch, WriteModeEnum::Update);
+  xyPatchIO->SetDownsamplingMethod(itk::OMEZarrNGFFImageIO::DownsamplingMethodEnum::Stride);
+  ITK_TRY_EXPECT_NO_EXCEPTION(xyPatchIO->Write(CopyRegion(image, xyPatch).data()));
+
+  ImageType::Pointer xyLevel1;
+  ITK_TRY_EXPECT_NO_EXCEPTION(xyLevel1 = ReadLevel(xyFileName.c_str(), 0));
+  if (!ImagesMatch(HalveXY(image), xyLevel1))
+  {
+    std::cerr << "Resolution level 1 downsampled along x and y only differs from the patched image" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
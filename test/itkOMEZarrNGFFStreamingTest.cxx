@@ -0,0 +1,213 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkMultiThreaderBase.h"
+#include "itkStreamingImageFilter.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+#include "itkImageIOBase.h"
+#include <vector>
+
+namespace
+{
+template <typename TImage>
+void
+validateImagesMatch(const TImage * expected, const TImage * actual)
+{
+  ITK_TEST_EXPECT_EQUAL(actual->GetLargestPossibleRegion(), expected->GetLargestPossibleRegion());
+  using IteratorType = itk::ImageRegionConstIteratorWithIndex<TImage>;
+  IteratorType expectedIt(expected, expected->GetLargestPossibleRegion());
+  for (expectedIt.GoToBegin(); !expectedIt.IsAtEnd(); ++expectedIt)
+  {
+    auto index = expectedIt.GetIndex();
+    itkAssertOrThrowMacro(expectedIt.Get() == actual->GetPixel(index), "Pixel value mismatch at index " << index);
+  }
+}
+} // namespace
+
+int
+itkOMEZarrNGFFStreamingTest(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input Output.zarr" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *                        inputFileName = argv[1];
+  const char *                        outputZarrFileName = argv[2];
+  static constexpr unsigned           NUMBER_OF_STREAM_DIVISIONS = 4;
+  static constexpr unsigned           CHUNK_SIZE = 64;
+  static constexpr itk::SizeValueType CACHE_POOL_SIZE = 16 * 1024 * 1024;
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  using ImageType = itk::Image<unsigned char, 2>;
+  auto fullImage = itk::ReadImage<ImageType>(inputFileName);
+
+  // Write in slabs, each of which must only fill in its own region of the store
+  auto writer = itk::ImageFileWriter<ImageType>::New();
+  writer->SetInput(fullImage);
+  writer->SetFileName(outputZarrFileName);
+  auto writerIO = itk::OMEZarrNGFFImageIO::New();
+  writerIO->SetChunkShape({ CHUNK_SIZE, CHUNK_SIZE });
+  writer->SetImageIO(writerIO);
+  writer->SetNumberOfStreamDivisions(NUMBER_OF_STREAM_DIVISIONS);
+  ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  validateImagesMatch(fullImage.GetPointer(), itk::ReadImage<ImageType>(outputZarrFileName).GetPointer());
+
+  // Read back in slabs with streamable regions aligned to the chunk grid
+  auto imageIO = itk::OMEZarrNGFFImageIO::New();
+  ITK_TEST_SET_GET_BOOLEAN(imageIO, ChunkAlignedStreaming, true);
+  ITK_TEST_SET_GET_BOOLEAN(imageIO, UseSharedContext, true);
+  imageIO->SetCachePoolSize(CACHE_POOL_SIZE);
+  ITK_TEST_SET_GET_VALUE(CACHE_POOL_SIZE, imageIO->GetCachePoolSize());
+  imageIO->SetReadAheadDepth(1);
+  ITK_TEST_SET_GET_VALUE(1u, imageIO->GetReadAheadDepth());
+
+  auto reader = itk::ImageFileReader<ImageType>::New();
+  reader->SetFileName(outputZarrFileName);
+  reader->SetImageIO(imageIO);
+
+  auto streamer = itk::StreamingImageFilter<ImageType, ImageType>::New();
+  streamer->SetInput(reader->GetOutput());
+  streamer->SetNumberOfStreamDivisions(NUMBER_OF_STREAM_DIVISIONS);
+  ITK_TRY_EXPECT_NO_EXCEPTION(streamer->Update());
+  validateImagesMatch(fullImage.GetPointer(), streamer->GetOutput());
+
+  // The streamable region must cover the requested region without exceeding the image bounds
+  itk::ImageIORegion requestedRegion(2);
+  requestedRegion.SetIndex(0, 32);
+  requestedRegion.SetIndex(1, 64);
+  requestedRegion.SetSize(0, 64);
+  requestedRegion.SetSize(1, 128);
+  itk::ImageIORegion largestRegion(2);
+  for (unsigned d = 0; d < 2; ++d)
+  {
+    largestRegion.SetIndex(d, 0);
+    largestRegion.SetSize(d, imageIO->GetDimensions(d));
+  }
+  const auto streamableRegion = imageIO->GenerateStreamableReadRegionFromRequestedRegion(requestedRegion);
+  std::cout << "Streamable region: " << streamableRegion << std::endl;
+  ITK_TEST_EXPECT_TRUE(streamableRegion.IsInside(requestedRegion));
+  ITK_TEST_EXPECT_TRUE(largestRegion.IsInside(streamableRegion));
+  for (unsigned d = 0; d < 2; ++d)
+  {
+    const bool isAlignedBegin = streamableRegion.GetIndex(d) % CHUNK_SIZE == 0;
+    const bool isAlignedEnd = (streamableRegion.GetIndex(d) + streamableRegion.GetSize(d)) % CHUNK_SIZE == 0 ||
+                              streamableRegion.GetSize(d) + streamableRegion.GetIndex(d) == largestRegion.GetSize(d);
+    ITK_TEST_EXPECT_TRUE(isAlignedBegin && isAlignedEnd);
+  }
+
+  // Explicitly prefetched regions are read in the background, and then read from the cache pool
+  auto prefetchIO = itk::OMEZarrNGFFImageIO::New();
+  prefetchIO->SetCachePoolSize(CACHE_POOL_SIZE);
+  prefetchIO->ImmutableStoreOn(); // cached chunks are not revalidated, which would count as fetching them
+  prefetchIO->CollectReadStatisticsOn();
+  prefetchIO->SetFileName(outputZarrFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(prefetchIO->ReadImageInformation());
+  ITK_TRY_EXPECT_NO_EXCEPTION(prefetchIO->Prefetch(requestedRegion));
+  ITK_TRY_EXPECT_NO_EXCEPTION(prefetchIO->WaitForPrefetches());
+  std::vector<ImageType::PixelType> prefetchedBuffer(requestedRegion.GetNumberOfPixels());
+  prefetchIO->SetIORegion(requestedRegion);
+  ITK_TRY_EXPECT_NO_EXCEPTION(prefetchIO->Read(prefetchedBuffer.data()));
+  using ReadStatisticEnum = itk::OMEZarrNGFFImageIO::ReadStatisticEnum;
+  ITK_TEST_EXPECT_TRUE(prefetchIO->GetLastReadStatistic(ReadStatisticEnum::ChunksFromCache) > 0.0);
+
+  // Without a cache pool there is nothing to prefetch into
+  auto uncachedIO = itk::OMEZarrNGFFImageIO::New();
+  uncachedIO->SetFileName(outputZarrFileName);
+  ITK_TRY_EXPECT_NO_EXCEPTION(uncachedIO->ReadImageInformation());
+  ITK_TRY_EXPECT_NO_EXCEPTION(uncachedIO->Prefetch(requestedRegion));
+  ITK_TRY_EXPECT_NO_EXCEPTION(uncachedIO->WaitForPrefetches());
+
+  imageIO->ChunkAlignedStreamingOff();
+  ITK_TEST_EXPECT_EQUAL(imageIO->GenerateStreamableReadRegionFromRequestedRegion(requestedRegion), requestedRegion);
+
+  // Thin slabs sharing a row of chunks are grown out to the same streamable region. Without a cache pool
+  // size, chunk-aligned streaming keeps a cache pool from which the second slab reads every chunk.
+  auto alignedIO = itk::OMEZarrNGFFImageIO::New();
+  alignedIO->ChunkAlignedStreamingOn();
+  alignedIO->ImmutableStoreOn(); // cached chunks are not revalidated, which would count as fetching them
+  alignedIO->CollectReadStatisticsOn();
+  alignedIO->SetFileName(outputZarrFileName);
+  ITK_TEST_EXPECT_EQUAL(alignedIO->GetCachePoolSize(), 0u);
+  ITK_TRY_EXPECT_NO_EXCEPTION(alignedIO->ReadImageInformation());
+  ITK_TEST_EXPECT_TRUE(alignedIO->GetTensorStoreContextSpec().find("\"cache_pool\"") != std::string::npos);
+  for (const itk::IndexValueType row : { 0, static_cast<itk::IndexValueType>(CHUNK_SIZE / 2) })
+  {
+    itk::ImageIORegion slab(2);
+    slab.SetIndex(0, 0);
+    slab.SetIndex(1, row);
+    slab.SetSize(0, alignedIO->GetDimensions(0));
+    slab.SetSize(1, CHUNK_SIZE / 2);
+    const auto alignedSlab = alignedIO->GenerateStreamableReadRegionFromRequestedRegion(slab);
+    ITK_TEST_EXPECT_EQUAL(alignedSlab.GetSize(1), CHUNK_SIZE);
+    std::vector<ImageType::PixelType> buffer(alignedSlab.GetNumberOfPixels());
+    alignedIO->SetIORegion(alignedSlab);
+    ITK_TRY_EXPECT_NO_EXCEPTION(alignedIO->Read(buffer.data()));
+  }
+  const double chunksRequested = alignedIO->GetLastReadStatistic(ReadStatisticEnum::ChunksRequested);
+  ITK_TEST_EXPECT_TRUE(chunksRequested > 0.0);
+  ITK_TEST_EXPECT_EQUAL(alignedIO->GetLastReadStatistic(ReadStatisticEnum::ChunksFromCache), chunksRequested);
+  ITK_TEST_EXPECT_EQUAL(alignedIO->GetLastReadStatistic(ReadStatisticEnum::BytesDecoded), 0.0);
+
+  // Instances sharing a context share its cache pool, so the second instance reads the chunks decoded by the first
+  std::vector<double> chunksFromCache;
+  for (int instance = 0; instance < 2; ++instance)
+  {
+    auto sharedIO = itk::OMEZarrNGFFImageIO::New();
+    sharedIO->UseSharedContextOn();
+    sharedIO->SetCachePoolSize(2 * CACHE_POOL_SIZE); // not shared with the instances above
+    sharedIO->ImmutableStoreOn();
+    sharedIO->CollectReadStatisticsOn();
+    reader->SetImageIO(sharedIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+    validateImagesMatch(fullImage.GetPointer(), reader->GetOutput());
+    chunksFromCache.push_back(sharedIO->GetLastReadStatistic(ReadStatisticEnum::ChunksFromCache));
+  }
+  ITK_TEST_EXPECT_EQUAL(chunksFromCache[0], 0.0);
+  ITK_TEST_EXPECT_TRUE(chunksFromCache[1] > 0.0);
+
+  // Decoding runs within ITK's thread budget by default, or within the limit of an instance
+  const auto globalNumberOfThreads = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
+  itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(1);
+  auto budgetIO = itk::OMEZarrNGFFImageIO::New();
+  ITK_TEST_EXPECT_EQUAL(0u, budgetIO->GetDataCopyConcurrency());
+  reader->SetImageIO(budgetIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  validateImagesMatch(fullImage.GetPointer(), reader->GetOutput());
+  ITK_TEST_EXPECT_TRUE(budgetIO->GetTensorStoreContextSpec().find("\"data_copy_concurrency\":{\"limit\":1}") !=
+                       std::string::npos);
+  budgetIO->SetDataCopyConcurrency(2);
+  ITK_TEST_SET_GET_VALUE(2u, budgetIO->GetDataCopyConcurrency());
+  reader->Modified();
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  validateImagesMatch(fullImage.GetPointer(), reader->GetOutput());
+  ITK_TEST_EXPECT_TRUE(budgetIO->GetTensorStoreContextSpec().find("\"data_copy_concurrency\":{\"limit\":2}") !=
+                       std::string::npos);
+  itk::MultiThreaderBase::SetGlobalDefaultNumberOfThreads(globalNumberOfThreads);
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
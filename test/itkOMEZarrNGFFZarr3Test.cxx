@@ -0,0 +1,120 @@
+/*=========================================================================
+ *
+ *  Copyright NumFOCUS
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         https://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include <string>
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkOMEZarrNGFFImageIO.h"
+#include "itkOMEZarrNGFFImageIOFactory.h"
+#include "itkTestingMacros.h"
+#include "itkTestingComparisonImageFilter.h"
+
+namespace
+{
+template <typename TImage>
+bool
+imagesMatch(const TImage * expected, const TImage * actual)
+{
+  auto comparer = itk::Testing::ComparisonImageFilter<TImage, TImage>::New();
+  comparer->SetValidInput(expected);
+  comparer->SetTestInput(actual);
+  comparer->Update();
+  return comparer->GetNumberOfPixelsWithDifferences() == 0;
+}
+} // namespace
+
+int
+itkOMEZarrNGFFZarr3Test(int argc, char * argv[])
+{
+  if (argc < 3)
+  {
+    std::cerr << "Missing parameters." << std::endl;
+    std::cerr << "Usage: " << std::endl;
+    std::cerr << itkNameOfTestExecutableMacro(argv) << " Input OutputPrefix" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char *      inputFileName = argv[1];
+  const std::string outputPrefix = argv[2];
+
+  itk::OMEZarrNGFFImageIOFactory::RegisterOneFactory();
+
+  using ImageType = itk::Image<unsigned char, 2>;
+  auto image = itk::ReadImage<ImageType>(inputFileName);
+
+  // ".zr3" file names select zarr v3 by default
+  const std::string zr3FileName = outputPrefix + ".zr3";
+  ITK_TRY_EXPECT_NO_EXCEPTION(itk::WriteImage(image, zr3FileName));
+  ITK_TEST_EXPECT_TRUE(imagesMatch(image.GetPointer(), itk::ReadImage<ImageType>(zr3FileName).GetPointer()));
+
+  // Sharded zarr v3 with two resolution levels
+  const std::string shardedFileName = outputPrefix + "_sharded.zarr";
+  {
+    auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+    zarrIO->SetZarrFormat(3);
+    ITK_TEST_SET_GET_VALUE(3u, zarrIO->GetZarrFormat());
+    zarrIO->SetChunkShape({ 32, 32 });
+    zarrIO->SetShardShape({ 128, 0 });
+    zarrIO->SetNumberOfResolutionLevels(2);
+    zarrIO->SetCompressor("BLOSC_ZSTD");
+
+    auto writer = itk::ImageFileWriter<ImageType>::New();
+    writer->SetInput(image);
+    writer->SetFileName(shardedFileName);
+    writer->SetImageIO(zarrIO);
+    ITK_TRY_EXPECT_NO_EXCEPTION(writer->Update());
+  }
+
+  auto zarrIO = itk::OMEZarrNGFFImageIO::New();
+  ITK_TEST_EXPECT_TRUE(zarrIO->CanReadFile(shardedFileName.c_str()));
+  auto reader = itk::ImageFileReader<ImageType>::New();
+  reader->SetFileName(shardedFileName);
+  reader->SetImageIO(zarrIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(reader->Update());
+  ITK_TEST_EXPECT_TRUE(imagesMatch(image.GetPointer(), reader->GetOutput()));
+
+  // Read a subregion, which only needs the chunks it overlaps
+  const ImageType::RegionType region({ { 40, 70 } }, { { 50, 30 } });
+  auto                        subregionReader = itk::ImageFileReader<ImageType>::New();
+  subregionReader->SetFileName(shardedFileName);
+  subregionReader->SetImageIO(zarrIO);
+  subregionReader->GetOutput()->SetRequestedRegion(region);
+  ITK_TRY_EXPECT_NO_EXCEPTION(subregionReader->Update());
+  ITK_TEST_EXPECT_EQUAL(subregionReader->GetOutput()->GetBufferedRegion(), region);
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    if (subregionReader->GetOutput()->GetPixel(it.GetIndex()) != it.Get())
+    {
+      std::cerr << "Pixel value mismatch at index " << it.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  // The lower resolution level is read through the same metadata
+  zarrIO->SetDatasetIndex(1);
+  auto levelReader = itk::ImageFileReader<ImageType>::New();
+  levelReader->SetFileName(shardedFileName);
+  levelReader->SetImageIO(zarrIO);
+  ITK_TRY_EXPECT_NO_EXCEPTION(levelReader->Update());
+  const auto levelSize = levelReader->GetOutput()->GetLargestPossibleRegion().GetSize();
+  ITK_TEST_EXPECT_EQUAL(levelSize[0], (image->GetLargestPossibleRegion().GetSize(0) + 1) / 2);
+  ITK_TEST_EXPECT_EQUAL(levelSize[1], (image->GetLargestPossibleRegion().GetSize(1) + 1) / 2);
+
+  std::cout << "Test finished" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -18,26 +18,22 @@
 
 # Test reading OME-Zarr NGFF chunked data over HTTP.
 #
-# This test spawns a Python web server child process to serve from the
-# test data directory on port 9999, then reads the local OME-Zarr file
-# as if it were remotely served.
+# This test writes an OME-Zarr store to a directory served by a local
+# HTTP server, whose base URL is read from the file the server recorded it
+# in at startup, then reads the store as if it were remotely served.
 
 import os
-import subprocess
 import sys
 
 import itk
 import numpy as np
 
-TEST_PORT = 9999
-LOCALHOST_BINDING = '127.0.0.1'
-
 itk.auto_progress(2)
 
 imageio = itk.OMEZarrNGFFImageIO.New()
 
-if(len(sys.argv) < 2):
-    raise ValueError('Expected arguments: <path/to/input.mha> <path/to/output.zarr>')
+if(len(sys.argv) < 4):
+    raise ValueError('Expected arguments: <path/to/input.mha> <path/to/served/output.zarr> <base_url_file>')
 
 # Test setup: create OME-Zarr store on local disk
 print(f"Reading {sys.argv[1]}")
@@ -51,13 +47,9 @@ image.SetOrigin(np.arange(0.6, 0.1 * image.GetImageDimension() + 0.59, 0.1))
 print(f"Writing {sys.argv[2]}")
 itk.imwrite(image, sys.argv[2], imageio=imageio, compression=False)
 
-# Serve files on "localhost" in the background
-p = subprocess.Popen([sys.executable,
-                      '-m', 'http.server', str(TEST_PORT),
-                      '--directory', os.path.dirname(sys.argv[2]),
-                      '--bind', LOCALHOST_BINDING])
-
-url = f'http://localhost:{TEST_PORT}/{os.path.basename(sys.argv[2])}'
+with open(sys.argv[3]) as f:
+    base_url = f.read().strip()
+url = f'{base_url}/{os.path.basename(sys.argv[2])}'
 
 print(f"Reading {url}")
 image2 = itk.imread(url, imageio=imageio)
@@ -70,6 +62,3 @@ assert np.all(np.array(itk.origin(image2)) == np.array(itk.origin(image))), 'Ima
 
 # Compare data
 assert np.all(itk.array_view_from_image(image2) == itk.array_view_from_image(image)), 'Image data mismatch'
-
-# Clean up
-p.kill()